@@ -0,0 +1,396 @@
+/*
+ * batch.c
+ *
+ * Batch runner, many (ROM, input, step budget) jobs on a pool of threads.
+ *
+ * Jobs are split into one contiguous range per worker. A worker takes
+ * jobs from the tail of its own range and, once that is empty, steals
+ * from the head of the others'. A range is a single 64 bit word updated
+ * with CAS, so taking a job never blocks. Every ROM is loaded once, by
+ * the first worker that needs it, into a program all workers share.
+ * Workers keep one machine for their whole life and attach it to the
+ * program of each job. In lockstep mode a worker gathers up to HVM_LANES
+ * jobs on the same program and budget and runs them as one group. With a
+ * prefix, the first worker to need a program also runs it that far once
+ * and jobs fork from the checkpoint instead of starting from reset.
+ */
+
+#include <memory.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "batch.h"
+#include "hvm.h"
+
+typedef struct {
+    char *path;
+    hvm_program *prog;
+    hvm_checkpoint *cp;
+    int err;
+    int loaded;
+    pthread_mutex_t lock;
+} BatchProgram;
+
+typedef struct {
+    char *rom;
+    int prog;
+    char *input;
+    long max_steps;
+    int ram_from;
+    int ram_to;
+} BatchJob;
+
+typedef struct {
+    int err;
+    long steps;
+    int halted;
+    int a, d, pc;
+    long usec;
+    int16_t *ram;
+} BatchResult;
+
+/* Jobs [head, tail) left to a worker, head in the upper 32 bits */
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;
+} BatchQueue;
+
+typedef struct {
+    BatchJob *jobs;
+    BatchResult *results;
+    BatchQueue *queues;
+    BatchProgram *progs;
+    int nprogs;
+    int nworkers;
+    int lanes;
+    long prefix;
+    unsigned flags;
+    const char *symbols;
+} Batch;
+
+typedef struct {
+    Batch *b;
+    int id;
+} BatchWorker;
+
+static int batch_parse(const char *manifest, BatchJob **jobs);
+static int batch_programs(Batch *, int njobs);
+static hvm_program *batch_program(const Batch *, int k, int *err);
+static hvm_checkpoint *batch_prefix(const Batch *, hvm_program *);
+static void *batch_worker(void *);
+static long batch_take(const Batch *, int id);
+static long queue_take(BatchQueue *, int from_head);
+static int job_start(const Batch *, hvm_machine *, int j);
+static void job_finish(const Batch *, hvm_machine *, int j, long steps, long usec);
+static int job_input(hvm_machine *, const char *path);
+
+
+int batch_run(const char *manifest, int nthreads, unsigned flags, const char *symbols, int lockstep, long prefix,
+              FILE *out) {
+    Batch b = {.flags=flags, .symbols=symbols, .lanes=lockstep ? HVM_LANES : 1, .prefix=prefix};
+    pthread_t *threads;
+    BatchWorker *workers;
+    int n, failed = 0;
+
+    if ((n = batch_parse(manifest, &b.jobs)) < 0)
+        return -1;
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > n && n > 0)
+        nthreads = n;
+
+    b.nworkers = nthreads;
+    b.nprogs = batch_programs(&b, n);
+    b.results = calloc(n ? n : 1, sizeof(BatchResult));
+    b.queues = aligned_alloc(_Alignof(BatchQueue), sizeof(BatchQueue) * nthreads);
+    threads = calloc(nthreads, sizeof(pthread_t));
+    workers = calloc(nthreads, sizeof(BatchWorker));
+    if (b.nprogs < 0 || !b.results || !b.queues || !threads || !workers) {
+        fprintf(stderr, "error: [%s] %s\n", manifest, hvm_strerror(HVM_ERR_NOMEM));
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < nthreads; ++i) {
+        uint64_t head = (uint64_t) n * i / nthreads;
+        uint64_t tail = (uint64_t) n * (i + 1) / nthreads;
+        atomic_init(&b.queues[i].range, head << 32u | tail);
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        workers[i].b = &b;
+        workers[i].id = i;
+        if (pthread_create(&threads[i], NULL, batch_worker, &workers[i])) {
+            // run the rest of the pool's work on the threads already started
+            nthreads = i;
+            break;
+        }
+    }
+    if (!nthreads)
+        batch_worker(&workers[0]);
+    for (int i = 0; i < nthreads; ++i)
+        pthread_join(threads[i], NULL);
+
+    fprintf(out, "#job\trom\tstatus\tsteps\tA\tD\tPC\tusec\tram\n");
+    for (int j = 0; j < n; ++j) {
+        BatchResult *r = &b.results[j];
+        fprintf(out, "%d\t%s\t", j, b.jobs[j].rom);
+        if (r->err) {
+            fprintf(out, "error: %s\n", hvm_strerror(r->err));
+            ++failed;
+        } else {
+            fprintf(out, "%s\t%ld\t%d\t%d\t%d\t%ld\t", r->halted ? "halt" : "limit",
+                    r->steps, r->a, r->d, r->pc, r->usec);
+            for (int i = 0; r->ram && i <= b.jobs[j].ram_to - b.jobs[j].ram_from; ++i)
+                fprintf(out, i ? ",%d" : "%d", r->ram[i]);
+            fputc('\n', out);
+        }
+        free(r->ram);
+        free(b.jobs[j].rom);
+        free(b.jobs[j].input);
+    }
+    for (int k = 0; k < b.nprogs; ++k) {
+        hvm_checkpoint_release(b.progs[k].cp);
+        hvm_program_release(b.progs[k].prog);
+        pthread_mutex_destroy(&b.progs[k].lock);
+    }
+
+    free(b.jobs);
+    free(b.progs);
+    free(b.results);
+    free(b.queues);
+    free(threads);
+    free(workers);
+    return failed;
+}
+
+static int batch_parse(const char *manifest, BatchJob **jobs) {
+    char line[4096], rom[1024], input[1024], steps[64], range[64];
+    BatchJob *job;
+    int n = 0, cap = 0;
+    FILE *fp = fopen(manifest, "r");
+
+    *jobs = NULL;
+    if (!fp) {
+        fprintf(stderr, "error: [%s] unable to open file\n", manifest);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        int fields = sscanf(line, "%1023s %1023s %63s %63s", rom, input, steps, range);
+        if (fields < 1 || rom[0] == '#')
+            continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 256;
+            if (!(*jobs = realloc(*jobs, sizeof(BatchJob) * cap))) {
+                fprintf(stderr, "error: [%s] %s\n", manifest, hvm_strerror(HVM_ERR_NOMEM));
+                exit(EXIT_FAILURE);
+            }
+        }
+        job = &(*jobs)[n++];
+        memset(job, 0, sizeof(*job));
+        job->rom = strdup(rom);
+        job->input = fields > 1 && strcmp(input, "-") ? strdup(input) : NULL;
+        job->max_steps = fields > 2 && strcmp(steps, "-") ? strtol(steps, NULL, 0) : -1;
+        job->ram_from = 0;
+        job->ram_to = -1;
+        if (fields > 3 && sscanf(range, "%d-%d", &job->ram_from, &job->ram_to) != 2)
+            job->ram_to = job->ram_from;
+    }
+    fclose(fp);
+    return n;
+}
+
+/* One entry per distinct ROM path, job->prog indexes it. Returns the number of entries. */
+static int batch_programs(Batch *b, int njobs) {
+    int size = 16;
+    int *slots;
+    int n = 0;
+
+    while (size < 2 * njobs)
+        size *= 2;
+    slots = malloc(sizeof(int) * size);
+    b->progs = calloc(njobs ? njobs : 1, sizeof(BatchProgram));
+    if (!slots || !b->progs) {
+        free(slots);
+        return -1;
+    }
+    memset(slots, -1, sizeof(int) * size);
+
+    for (int j = 0; j < njobs; ++j) {
+        const char *path = b->jobs[j].rom;
+        uint32_t h = 2166136261u;
+
+        // FNV-1a, open addressing
+        for (const char *c = path; *c; ++c)
+            h = (h ^ (unsigned char) *c) * 16777619u;
+        for (h &= size - 1; slots[h] >= 0 && strcmp(b->progs[slots[h]].path, path); h = (h + 1) & (size - 1));
+        if (slots[h] < 0) {
+            slots[h] = n;
+            b->progs[n].path = b->jobs[j].rom;
+            pthread_mutex_init(&b->progs[n].lock, NULL);
+            ++n;
+        }
+        b->jobs[j].prog = slots[h];
+    }
+    free(slots);
+    return n;
+}
+
+/* Program k, loaded by whichever worker asks for it first */
+static hvm_program *batch_program(const Batch *b, int k, int *err) {
+    BatchProgram *bp = &b->progs[k];
+
+    pthread_mutex_lock(&bp->lock);
+    if (!bp->loaded) {
+        if (!(bp->prog = hvm_program_create(b->flags))) {
+            bp->err = HVM_ERR_NOMEM;
+        } else if ((b->symbols && (bp->err = hvm_program_load_symbols(bp->prog, b->symbols))) ||
+                   (bp->err = hvm_program_load_file(bp->prog, bp->path))) {
+            hvm_program_release(bp->prog);
+            bp->prog = NULL;
+        } else if (b->prefix > 0 && !(bp->cp = batch_prefix(b, bp->prog))) {
+            bp->err = HVM_ERR_NOMEM;
+        }
+        bp->loaded = 1;
+    }
+    pthread_mutex_unlock(&bp->lock);
+
+    *err = bp->err;
+    return bp->prog;
+}
+
+/* Run a fresh machine prefix instrs into prog and checkpoint it */
+static hvm_checkpoint *batch_prefix(const Batch *b, hvm_program *prog) {
+    hvm_machine *m = hvm_create(b->flags);
+    hvm_checkpoint *cp;
+
+    if (!m)
+        return NULL;
+    hvm_attach(m, prog);
+    hvm_run(m, b->prefix);
+    cp = hvm_checkpoint_create(m);
+    hvm_destroy(m);
+    return cp;
+}
+
+static void *batch_worker(void *arg) {
+    BatchWorker *w = arg;
+    const Batch *b = w->b;
+    hvm_machine *ms[HVM_LANES];
+    long counts[HVM_LANES];
+    int group[HVM_LANES];
+    struct timespec t0, t1;
+    int lanes = 0, k;
+    long j = -1, max_steps, usec;
+
+    while (lanes < b->lanes && (ms[lanes] = hvm_create(b->flags)))
+        ++lanes;
+
+    for (;;) {
+        // gather jobs on the same program and budget, a job that does not fit starts the next group
+        k = 0;
+        while (k < lanes && (j >= 0 || (j = batch_take(b, w->id)) >= 0)) {
+            if (k && (b->jobs[j].prog != b->jobs[group[0]].prog || b->jobs[j].max_steps != b->jobs[group[0]].max_steps))
+                break;
+            if (!job_start(b, ms[k], j))
+                group[k++] = j;
+            j = -1;
+        }
+        if (!k) {
+            // out of memory for even one machine, fail the remaining jobs
+            if (!lanes && (j = batch_take(b, w->id)) >= 0) {
+                b->results[j].err = HVM_ERR_NOMEM;
+                j = -1;
+                continue;
+            }
+            break;
+        }
+
+        max_steps = b->jobs[group[0]].max_steps;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (k == 1)
+            counts[0] = hvm_run(ms[0], max_steps);
+        else
+            hvm_run_lockstep(ms, k, max_steps, counts);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        usec = (t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_nsec - t0.tv_nsec) / 1000;
+        for (int i = 0; i < k; ++i)
+            job_finish(b, ms[i], group[i], counts[i], usec);
+    }
+
+    for (int i = 0; i < lanes; ++i)
+        hvm_destroy(ms[i]);
+    return NULL;
+}
+
+/* Next job from the worker's own range, else stolen from another one, -1 once all are taken */
+static long batch_take(const Batch *b, int id) {
+    long j = queue_take(&b->queues[id], 0);
+
+    // ranges never grow, all empty means all jobs are taken
+    for (int i = 1; j < 0 && i < b->nworkers; ++i)
+        j = queue_take(&b->queues[(id + i) % b->nworkers], 1);
+    return j;
+}
+
+static long queue_take(BatchQueue *q, int from_head) {
+    uint64_t r = atomic_load_explicit(&q->range, memory_order_relaxed);
+    uint64_t next;
+
+    do {
+        uint32_t head = r >> 32u;
+        uint32_t tail = (uint32_t) r;
+        if (head >= tail)
+            return -1;
+        next = from_head ? r + (1ull << 32u) : r - 1;
+    } while (!atomic_compare_exchange_weak(&q->range, &r, next));
+
+    return from_head ? (long) (r >> 32u) : (long) (uint32_t) r - 1;
+}
+
+/* Attach m to job j's program, or fork it from the prefix, and write its input. Returns non zero if the job failed. */
+static int job_start(const Batch *b, hvm_machine *m, int j) {
+    const BatchJob *job = &b->jobs[j];
+    BatchResult *r = &b->results[j];
+    hvm_program *prog = batch_program(b, job->prog, &r->err);
+
+    if (r->err)
+        return r->err;
+    if (b->progs[job->prog].cp)
+        hvm_fork(m, b->progs[job->prog].cp);
+    else
+        hvm_attach(m, prog);
+    if (job->input)
+        r->err = job_input(m, job->input);
+    return r->err;
+}
+
+static void job_finish(const Batch *b, hvm_machine *m, int j, long steps, long usec) {
+    const BatchJob *job = &b->jobs[j];
+    BatchResult *r = &b->results[j];
+
+    r->steps = steps;
+    r->usec = usec;
+    r->halted = hvm_halted(m);
+    r->a = hvm_get_reg(m, HVM_REG_A);
+    r->d = hvm_get_reg(m, HVM_REG_D);
+    r->pc = hvm_get_reg(m, HVM_REG_PC);
+    if (job->ram_to >= job->ram_from && (r->ram = malloc(sizeof(int16_t) * (job->ram_to - job->ram_from + 1)))) {
+        for (int i = job->ram_from; i <= job->ram_to; ++i)
+            r->ram[i - job->ram_from] = hvm_read(m, i);
+    }
+}
+
+static int job_input(hvm_machine *m, const char *path) {
+    unsigned addr;
+    int value;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp)
+        return HVM_ERR_IO;
+    while (fscanf(fp, "%u %d", &addr, &value) == 2)
+        hvm_write(m, addr, value);
+    fclose(fp);
+    return HVM_OK;
+}
@@ -0,0 +1,28 @@
+/*
+ * batch.h
+ */
+
+#ifndef HVM_BATCH_H
+#define HVM_BATCH_H
+
+#include <stdio.h>
+
+/*
+ * Run every job of a manifest on nthreads workers and write one result
+ * record per job, in manifest order, to out. Manifest lines are
+ *
+ *   rom.hex [input|-] [max_steps|-] [from-to]
+ *
+ * input holds 'address value' pairs written to RAM before the run,
+ * from-to is a RAM range whose words are added to the record. With
+ * lockstep set, jobs on the same ROM and budget run in lockstep groups.
+ * With prefix > 0 every ROM runs prefix instrs once and its jobs start
+ * from there, copy-on-write, with input written at that point; steps and
+ * max_steps then count from the end of the prefix.
+ * Returns the number of jobs that failed with an error record, 0 if every
+ * job ran, -1 if the manifest could not be read.
+ */
+int batch_run(const char *manifest, int nthreads, unsigned flags, const char *symbols, int lockstep, long prefix,
+              FILE *out);
+
+#endif //HVM_BATCH_H
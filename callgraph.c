@@ -0,0 +1,233 @@
+/*
+ * callgraph.c
+ *
+ * Call graph profiler. A block hook rebuilds the call stack from the VM
+ * translator's calling convention: a call leaves LCL equal to SP with the
+ * return address, the word after the call's jump, five below SP. A return
+ * is a jump to the return address of a frame on the stack. Instrs are
+ * added to the calling context tree node of the function running them.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "callgraph.h"
+
+#define R_SP 0
+#define R_LCL 1
+
+typedef struct {
+    uint16_t fn;
+    int parent;
+    int child;      // first child
+    int sibling;    // next child of the parent
+    uint64_t self;
+    uint64_t total; // self and every descendant, filled in when writing
+    unsigned long calls;
+} CallNode;
+
+typedef struct {
+    int node;
+    uint16_t ret;
+} CallFrame;
+
+struct callgraph {
+    hvm_machine *m;
+    CallNode *nodes;
+    int count, cap;
+    CallFrame *stack;
+    int depth, stack_cap;
+};
+
+static int node_child(callgraph *g, int parent, uint16_t fn) {
+    CallNode *nodes;
+    int n;
+
+    for (n = g->nodes[parent].child; n >= 0; n = g->nodes[n].sibling) {
+        if (g->nodes[n].fn == fn)
+            return n;
+    }
+    if (g->count == g->cap) {
+        if (!(nodes = realloc(g->nodes, sizeof(CallNode) * g->cap * 2)))
+            return -1;
+        g->nodes = nodes;
+        g->cap *= 2;
+    }
+    n = g->count++;
+    g->nodes[n] = (CallNode) {.fn=fn, .parent=parent, .child=-1, .sibling=g->nodes[parent].child};
+    g->nodes[parent].child = n;
+    return n;
+}
+
+static void callgraph_block(void *ctx, hvm_machine *m, uint16_t entry, uint16_t next, unsigned long instrs) {
+    callgraph *g = ctx;
+    uint16_t to = hvm_get_reg(m, HVM_REG_PC);
+    int16_t sp = hvm_read(m, R_SP);
+    CallFrame *stack;
+    int n;
+
+    (void) entry;
+    g->nodes[g->stack[g->depth - 1].node].self += instrs;
+    if (to == next)
+        return;
+
+    if (hvm_read(m, R_LCL) == sp && (uint16_t) hvm_read(m, sp - 5) == next) {
+        if (g->depth == g->stack_cap) {
+            if (!(stack = realloc(g->stack, sizeof(CallFrame) * g->stack_cap * 2)))
+                return;
+            g->stack = stack;
+            g->stack_cap *= 2;
+        }
+        if ((n = node_child(g, g->stack[g->depth - 1].node, to)) >= 0) {
+            ++g->nodes[n].calls;
+            g->stack[g->depth++] = (CallFrame) {.node=n, .ret=next};
+        }
+        return;
+    }
+    // a return may unwind frames whose returns went unseen
+    for (n = g->depth - 1; n > 0; --n) {
+        if (g->stack[n].ret == to) {
+            g->depth = n;
+            return;
+        }
+    }
+}
+
+callgraph *callgraph_attach(hvm_machine *m) {
+    callgraph *g = calloc(1, sizeof(callgraph));
+
+    if (!g)
+        return NULL;
+    g->cap = g->stack_cap = 256;
+    g->nodes = malloc(sizeof(CallNode) * g->cap);
+    g->stack = malloc(sizeof(CallFrame) * g->stack_cap);
+    if (!g->nodes || !g->stack) {
+        callgraph_destroy(g);
+        return NULL;
+    }
+    g->m = m;
+    g->nodes[0] = (CallNode) {.fn=hvm_get_reg(m, HVM_REG_PC), .parent=-1, .child=-1, .sibling=-1};
+    g->count = 1;
+    g->stack[0] = (CallFrame) {.node=0};
+    g->depth = 1;
+    hvm_set_block_hook(m, callgraph_block, g);
+    return g;
+}
+
+void callgraph_destroy(callgraph *g) {
+    if (!g)
+        return;
+    if (g->m)
+        hvm_set_block_hook(g->m, NULL, NULL);
+    free(g->nodes);
+    free(g->stack);
+    free(g);
+}
+
+static void fn_name(const callgraph *g, uint16_t fn, char *buf, size_t len) {
+    const char *name = hvm_label(g->m, fn);
+
+    if (name)
+        snprintf(buf, len, "%s", name);
+    else
+        snprintf(buf, len, "@%u", fn);
+}
+
+/* Children come after their parent, so totals add up walking back */
+static void node_totals(CallNode *nodes, int count) {
+    for (int n = 0; n < count; ++n)
+        nodes[n].total = nodes[n].self;
+    for (int n = count - 1; n > 0; --n)
+        nodes[nodes[n].parent].total += nodes[n].total;
+}
+
+typedef struct {
+    uint16_t fn;
+    uint64_t incl, excl;
+    unsigned long calls;
+} CallFn;
+
+static int by_inclusive(const void *a, const void *b) {
+    const CallFn *x = a, *y = b;
+
+    if (x->incl != y->incl)
+        return x->incl < y->incl ? 1 : -1;
+    return x->fn - y->fn;
+}
+
+int callgraph_write_table(const callgraph *g, const char *path) {
+    CallFn *fns = calloc(HVM_ROM_SIZE, sizeof(CallFn));
+    int *slot = malloc(sizeof(int) * HVM_ROM_SIZE);
+    int n = 0;
+    char name[160];
+    FILE *fp;
+
+    if (!fns || !slot || !(fp = fopen(path, "w"))) {
+        free(fns);
+        free(slot);
+        return -1;
+    }
+    node_totals(g->nodes, g->count);
+    for (int i = 0; i < HVM_ROM_SIZE; ++i)
+        slot[i] = -1;
+
+    for (int i = 0; i < g->count; ++i) {
+        const CallNode *node = &g->nodes[i];
+        int recursive = 0;
+
+        if (slot[node->fn] < 0) {
+            slot[node->fn] = n;
+            fns[n++].fn = node->fn;
+        }
+        // recursive calls are already inside an outer call's inclusive count
+        for (int p = node->parent; p >= 0 && !recursive; p = g->nodes[p].parent)
+            recursive = g->nodes[p].fn == node->fn;
+        if (!recursive)
+            fns[slot[node->fn]].incl += node->total;
+        fns[slot[node->fn]].excl += node->self;
+        fns[slot[node->fn]].calls += node->calls;
+    }
+    qsort(fns, n, sizeof(CallFn), by_inclusive);
+
+    fprintf(fp, "# %llu instrs\n", (unsigned long long) g->nodes[0].total);
+    fprintf(fp, "#%15s %7s %16s %7s %10s  %s\n", "inclusive", "%", "exclusive", "%", "calls", "function");
+    for (int i = 0; i < n; ++i) {
+        double total = g->nodes[0].total ? (double) g->nodes[0].total : 1.0;
+
+        fn_name(g, fns[i].fn, name, sizeof(name));
+        fprintf(fp, "%16llu %6.2f%% %16llu %6.2f%% %10lu  %s\n", (unsigned long long) fns[i].incl,
+                100.0 * fns[i].incl / total, (unsigned long long) fns[i].excl, 100.0 * fns[i].excl / total,
+                fns[i].calls, name);
+    }
+
+    fclose(fp);
+    free(fns);
+    free(slot);
+    return 0;
+}
+
+/* Write node's stack, root first, as 'a;b;c' */
+static void node_stack(const callgraph *g, int n, FILE *fp) {
+    char name[160];
+
+    if (g->nodes[n].parent >= 0) {
+        node_stack(g, g->nodes[n].parent, fp);
+        fputc(';', fp);
+    }
+    fn_name(g, g->nodes[n].fn, name, sizeof(name));
+    fputs(name, fp);
+}
+
+int callgraph_write_folded(const callgraph *g, const char *path) {
+    FILE *fp = fopen(path, "w");
+
+    if (!fp)
+        return -1;
+    for (int n = 0; n < g->count; ++n) {
+        if (!g->nodes[n].self)
+            continue;
+        node_stack(g, n, fp);
+        fprintf(fp, " %llu\n", (unsigned long long) g->nodes[n].self);
+    }
+    fclose(fp);
+    return 0;
+}
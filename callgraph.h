@@ -0,0 +1,22 @@
+/*
+ * callgraph.h
+ */
+
+#ifndef HVM_CALLGRAPH_H
+#define HVM_CALLGRAPH_H
+
+#include "hvm.h"
+
+typedef struct callgraph callgraph;
+
+/* Follow VM translator calls and returns on m from its current PC, NULL if out of memory */
+callgraph *callgraph_attach(hvm_machine *m);
+void callgraph_destroy(callgraph *g);
+
+/* Inclusive and exclusive instrs per function, hottest inclusive first */
+int callgraph_write_table(const callgraph *g, const char *path);
+
+/* One 'caller;callee;... instrs' line per call stack, for flamegraph tools */
+int callgraph_write_folded(const callgraph *g, const char *path);
+
+#endif //HVM_CALLGRAPH_H
@@ -0,0 +1,118 @@
+/*
+ * checkpoint.c
+ *
+ * Checkpoint files. Taken between run slices, at a block entry, where the
+ * registers and RAM are all there is to a machine: restored, it goes on
+ * as if it had never stopped.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+/* All of buf, or -1 */
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t) n;
+    }
+    return 0;
+}
+
+int checkpoint_write(const hvm_machine *m, unsigned flags, long instrs, const char *path) {
+    char *buf = calloc(1, CKPT_SIZE);
+    struct hvm_ckpt *head = (struct hvm_ckpt *) buf;
+    int16_t *ram = (int16_t *) (buf + CKPT_RAM);
+    size_t len = strlen(path) + 5;
+    char *tmp = malloc(len);
+    int fd = -1, err = -1;
+
+    if (!buf || !tmp)
+        goto out;
+    memcpy(head->magic, CKPT_MAGIC, 4);
+    head->version = CKPT_VERSION;
+    head->rom_hash = hvm_rom_hash(m);
+    head->rom_len = (uint32_t) hvm_rom_len(m);
+    head->flags = flags;
+    head->a = hvm_get_reg(m, HVM_REG_A);
+    head->d = hvm_get_reg(m, HVM_REG_D);
+    head->pc = hvm_get_reg(m, HVM_REG_PC);
+    head->instrs = (uint64_t) instrs;
+    for (int a = 0; a < HVM_RAM_SIZE; ++a)
+        ram[a] = hvm_read(m, (uint16_t) a);
+
+    snprintf(tmp, len, "%s.tmp", path);
+    if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        goto out;
+    if (write_all(fd, buf, CKPT_SIZE) || fsync(fd) || close(fd)) {
+        fd = -1;
+        unlink(tmp);
+        goto out;
+    }
+    fd = -1;
+    if (rename(tmp, path))
+        unlink(tmp);
+    else
+        err = 0;
+
+out:
+    if (fd >= 0)
+        close(fd);
+    free(tmp);
+    free(buf);
+    return err;
+}
+
+int checkpoint_restore(hvm_machine *m, unsigned flags, const char *path, long *instrs) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    char *map;
+    const struct hvm_ckpt *head;
+
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size != CKPT_SIZE) {
+        close(fd);
+        return -2;
+    }
+    // private, the machine's writes never reach the file
+    map = mmap(NULL, CKPT_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    head = (const struct hvm_ckpt *) map;
+    if (memcmp(head->magic, CKPT_MAGIC, 4) || head->version != CKPT_VERSION) {
+        munmap(map, CKPT_SIZE);
+        return -2;
+    }
+    if (head->rom_hash != hvm_rom_hash(m) || head->rom_len != (uint32_t) hvm_rom_len(m)) {
+        munmap(map, CKPT_SIZE);
+        return -3;
+    }
+    if ((head->flags ^ flags) & HVM_EXTENDED) {
+        munmap(map, CKPT_SIZE);
+        return -4;
+    }
+
+    hvm_ram_adopt(m, (int16_t *) (map + CKPT_RAM));
+    hvm_set_reg(m, HVM_REG_A, head->a);
+    hvm_set_reg(m, HVM_REG_D, head->d);
+    hvm_set_reg(m, HVM_REG_PC, head->pc);
+    *instrs = (long) head->instrs;
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * checkpoint.h
+ *
+ * Machine state saved to a file, hvm --checkpoint-every and --restore. A
+ * CKPT_RAM byte header, then RAM as HVM_RAM_SIZE 16 bit words, all in
+ * host byte order so that restoring maps the file instead of reading it.
+ */
+
+#ifndef HVM_CHECKPOINT_H
+#define HVM_CHECKPOINT_H
+
+#include <stdint.h>
+#include "hvm.h"
+
+#define CKPT_MAGIC "HVMK"
+#define CKPT_VERSION 1
+#define CKPT_RAM 4096
+#define CKPT_SIZE (CKPT_RAM + HVM_RAM_SIZE * 2)
+
+struct hvm_ckpt {
+    char magic[4];
+    uint32_t version;
+    uint32_t rom_hash;          // hvm_rom_hash()
+    uint32_t rom_len;
+    uint32_t flags;             // hvm_flags the machine was created with
+    int32_t a, d, pc;
+    uint64_t instrs;            // run before the checkpoint was taken
+};
+
+/*
+ * Save m, created with flags, after instrs, to path. The file is written
+ * aside and renamed over path, so a run stopped meanwhile leaves the
+ * previous checkpoint. Returns 0, -1 if it could not be written.
+ */
+int checkpoint_write(const hvm_machine *m, unsigned flags, long instrs, const char *path);
+
+/*
+ * Continue on m, created with flags, from the checkpoint at path, mapped
+ * privately for the life of the process as m's RAM, see hvm_ram_adopt().
+ * *instrs receives the instrs run before it. Returns 0, -1 if it could
+ * not be opened or mapped, -2 if it is no checkpoint, -3 if it was taken
+ * of another ROM, -4 with or without HVM_EXTENDED unlike flags.
+ */
+int checkpoint_restore(hvm_machine *m, unsigned flags, const char *path, long *instrs);
+
+#endif //HVM_CHECKPOINT_H
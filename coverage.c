@@ -0,0 +1,162 @@
+/*
+ * coverage.c
+ *
+ * Coverage files and report. The VM marks block entries and the direction
+ * every jump went, words run are derived from the entries: a block runs
+ * straight from its entry through the next jump. A Jack OS routine run
+ * natively shows its first word only.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include "coverage.h"
+#include "disasm.h"
+#include "hvm.h"
+
+#define COVER_MAGIC "HVMC"
+#define COVER_HEAD 12
+
+#define BIT(bits, at, addr) ((bits)[(at) + ((addr) >> 3u)] >> ((addr) & 7u) & 1u)
+
+static void put32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i)
+        p[i] = (uint8_t) (v >> (8u * i));
+}
+
+int coverage_merge(const hvm_machine *m, uint8_t *bits, const char *path) {
+    uint8_t head[COVER_HEAD], want[COVER_HEAD];
+    uint8_t *old = malloc(HVM_COVER_BYTES);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    FILE *fp;
+    size_t n;
+    int err = -1;
+
+    memcpy(want, COVER_MAGIC, 4);
+    put32(want + 4, hvm_rom_hash(m));
+    put32(want + 8, (uint32_t) hvm_rom_len(m));
+    if (!old || fd < 0 || flock(fd, LOCK_EX) || !(fp = fdopen(fd, "r+b"))) {
+        if (fd >= 0)
+            close(fd);
+        free(old);
+        return -1;
+    }
+
+    // an empty file is a new one
+    if ((n = fread(head, 1, COVER_HEAD, fp)) == COVER_HEAD) {
+        if (memcmp(head, want, COVER_HEAD)) {
+            err = -2;
+            goto out;
+        }
+        if (fread(old, 1, HVM_COVER_BYTES, fp) != HVM_COVER_BYTES)
+            goto out;
+        for (int i = 0; i < HVM_COVER_BYTES; ++i)
+            bits[i] |= old[i];
+    } else if (n) {
+        goto out;
+    }
+    rewind(fp);
+    if (fwrite(want, 1, COVER_HEAD, fp) == COVER_HEAD && fwrite(bits, 1, HVM_COVER_BYTES, fp) == HVM_COVER_BYTES &&
+        !fflush(fp))
+        err = 0;
+
+out:
+    // closing drops the lock
+    fclose(fp);
+    free(old);
+    return err;
+}
+
+/* Name of the nearest label at or before each word */
+static void print_addr(FILE *fp, const char **label, const uint16_t *label_at, int pc) {
+    if (label[pc] && label_at[pc] == pc)
+        fprintf(fp, "%s", label[pc]);
+    else if (label[pc])
+        fprintf(fp, "%s+%d", label[pc], pc - label_at[pc]);
+}
+
+int coverage_report(const hvm_machine *m, unsigned flags, const uint8_t *bits, const char *path) {
+    int len = hvm_rom_len(m);
+    int extended = (flags & HVM_EXTENDED) != 0;
+    uint8_t *run = calloc(HVM_ROM_SIZE, 1);
+    const char **label = calloc(HVM_ROM_SIZE, sizeof(char *));
+    uint16_t *label_at = calloc(HVM_ROM_SIZE, sizeof(uint16_t));
+    int words = 0, entries = 0, branches = 0, both = 0, taken = 0, not_taken = 0;
+    char text[32];
+    FILE *fp;
+
+    if (!run || !label || !label_at || !(fp = fopen(path, "w"))) {
+        free(run);
+        free(label);
+        free(label_at);
+        return -1;
+    }
+
+    for (int e = 0; e < len; ++e) {
+        if (!BIT(bits, HVM_COVER_ENTRY, e))
+            continue;
+        ++entries;
+        for (int pc = e; pc < len && !run[pc]; ++pc) {
+            run[pc] = 1;
+            if (disasm_is_jump(hvm_rom(m, pc), extended))
+                break;
+        }
+    }
+    for (int pc = 0; pc < len; ++pc) {
+        uint16_t w = hvm_rom(m, pc);
+        const char *name = hvm_label(m, pc);
+
+        label[pc] = name ? name : pc ? label[pc - 1] : NULL;
+        label_at[pc] = name ? pc : pc ? label_at[pc - 1] : 0;
+        words += run[pc];
+        if (disasm_is_jump(w, extended) && (w & 0x7u) != 0x7u) {
+            int t = BIT(bits, HVM_COVER_TAKEN, pc), f = BIT(bits, HVM_COVER_NOT_TAKEN, pc);
+            ++branches;
+            both += t && f;
+            taken += t && !f;
+            not_taken += !t && f;
+        }
+    }
+
+    fprintf(fp, "# words run        %d of %d (%.1f%%)\n", words, len, len ? 100.0 * words / len : 0.0);
+    fprintf(fp, "# blocks entered   %d\n", entries);
+    fprintf(fp, "# conditional jumps %d: both ways %d, taken only %d, not taken only %d, never run %d (%.1f%% of directions)\n",
+            branches, both, taken, not_taken, branches - both - taken - not_taken,
+            branches ? 100.0 * (2 * both + taken + not_taken) / (2 * branches) : 0.0);
+
+    fprintf(fp, "# words never run\n");
+    for (int pc = 0; pc < len; ++pc) {
+        int end = pc;
+
+        if (run[pc])
+            continue;
+        while (end + 1 < len && !run[end + 1])
+            ++end;
+        fprintf(fp, "%6d-%-6d %5d  ", pc, end, end - pc + 1);
+        print_addr(fp, label, label_at, pc);
+        fputc('\n', fp);
+        pc = end;
+    }
+
+    fprintf(fp, "# jumps that went one way only\n");
+    for (int pc = 0; pc < len; ++pc) {
+        uint16_t w = hvm_rom(m, pc);
+        int t = BIT(bits, HVM_COVER_TAKEN, pc), f = BIT(bits, HVM_COVER_NOT_TAKEN, pc);
+
+        if (!disasm_is_jump(w, extended) || (w & 0x7u) == 0x7u || t == f)
+            continue;
+        disasm(w, extended, text, sizeof(text));
+        fprintf(fp, "%6d  %-16s %-10s ", pc, text, t ? "taken" : "not taken");
+        print_addr(fp, label, label_at, pc);
+        fputc('\n', fp);
+    }
+
+    fclose(fp);
+    free(run);
+    free(label);
+    free(label_at);
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * coverage.h
+ */
+
+#ifndef HVM_COVERAGE_H
+#define HVM_COVERAGE_H
+
+#include <stdint.h>
+#include "hvm.h"
+
+/*
+ * OR the bitmap file at path into bits, HVM_COVER_BYTES collected with
+ * hvm_set_cover_bits(), and write the result back, creating the file if
+ * there is none. The file is locked meanwhile, so runs in parallel can
+ * share one. Returns 0, -1 if it could not be read or written, -2 if it
+ * was written for another ROM.
+ */
+int coverage_merge(const hvm_machine *m, uint8_t *bits, const char *path);
+
+/*
+ * Write the coverage summary for m, created with flags, to path: words
+ * run, blocks entered and conditional jumps by the directions they went,
+ * then the ranges of words never run and the jumps that went one way only,
+ * labelled from the symbol map when there is one. Returns 0, -1 if path
+ * could not be written.
+ */
+int coverage_report(const hvm_machine *m, unsigned flags, const uint8_t *bits, const char *path);
+
+#endif //HVM_COVERAGE_H
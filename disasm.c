@@ -0,0 +1,77 @@
+/*
+ * disasm.c
+ *
+ * Hack disassembler over the h_opcodes encodings.
+ */
+
+#include <stdio.h>
+#include "disasm.h"
+#include "hopcodes.h"
+
+static const char *dests[] = {"", "M=", "D=", "MD=", "A=", "AM=", "AD=", "AMD="};
+static const char *jmps[] = {"", ";JGT", ";JEQ", ";JGE", ";JLT", ";JNE", ";JLE", ";JMP"};
+
+static const char *comp_name(uint16_t comp) {
+    switch (comp) {
+        case COMP_ZERO:         return "0";
+        case COMP_ONE:          return "1";
+        case COMP_MINUS_1:      return "-1";
+        case COMP_D:            return "D";
+        case COMP_A:            return "A";
+        case COMP_M:            return "M";
+        case COMP_NOT_D:        return "!D";
+        case COMP_NOT_A:        return "!A";
+        case COMP_NOT_M:        return "!M";
+        case COMP_MINUS_D:      return "-D";
+        case COMP_MINUS_A:      return "-A";
+        case COMP_MINUS_M:      return "-M";
+        case COMP_D_PLUS_1:     return "D+1";
+        case COMP_A_PLUS_1:     return "A+1";
+        case COMP_M_PLUS_1:     return "M+1";
+        case COMP_D_MINUS_1:    return "D-1";
+        case COMP_A_MINUS_1:    return "A-1";
+        case COMP_M_MINUS_1:    return "M-1";
+        case COMP_D_PLUS_A:     return "D+A";
+        case COMP_D_PLUS_M:     return "D+M";
+        case COMP_D_MINUS_A:    return "D-A";
+        case COMP_D_MINUS_M:    return "D-M";
+        case COMP_A_MINUS_D:    return "A-D";
+        case COMP_M_MINUS_D:    return "M-D";
+        case COMP_D_AND_A:      return "D&A";
+        case COMP_D_AND_M:      return "D&M";
+        case COMP_D_OR_A:       return "D|A";
+        case COMP_D_OR_M:       return "D|M";
+        case COMP_A_SHR:        return "A>>";
+        case COMP_D_SHR:        return "D>>";
+        case COMP_A_SHL:        return "A<<";
+        case COMP_D_SHL:        return "D<<";
+        case COMP_M_SHR:        return "M>>";
+        case COMP_M_SHL:        return "M<<";
+        case COMP_D_MUL_A:      return "D*A";
+        case COMP_D_MUL_M:      return "D*M";
+        default:                return NULL;
+    }
+}
+
+static int is_c_instr(uint16_t instr, int extended) {
+    uint16_t prefix = instr >> 13u;
+
+    return prefix == 0x7u || (extended && prefix == 0x5u);
+}
+
+void disasm(uint16_t instr, int extended, char *buf, size_t len) {
+    const char *comp;
+
+    if (!is_c_instr(instr, extended)) {
+        snprintf(buf, len, "@%u", instr);
+        return;
+    }
+    if ((comp = comp_name(instr >> 6u)))
+        snprintf(buf, len, "%s%s%s", dests[(instr >> 3u) & 0x7u], comp, jmps[instr & 0x7u]);
+    else
+        snprintf(buf, len, "?0x%04x", instr);
+}
+
+int disasm_is_jump(uint16_t instr, int extended) {
+    return is_c_instr(instr, extended) && (instr & 0x7u);
+}
@@ -0,0 +1,17 @@
+/*
+ * disasm.h
+ */
+
+#ifndef HVM_DISASM_H
+#define HVM_DISASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hack assembly for instr into buf, 101 prefixed C instrs with extended */
+void disasm(uint16_t instr, int extended, char *buf, size_t len);
+
+/* Whether instr is a C instr with jump bits */
+int disasm_is_jump(uint16_t instr, int extended);
+
+#endif //HVM_DISASM_H
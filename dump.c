@@ -0,0 +1,259 @@
+/*
+ * dump.c
+ *
+ * Machine state dumps, written while the machine is paused between run
+ * slices, and snapshots in formats meant for scripts. Words are formatted
+ * by hand into a buffer written out in 64K blocks, a printf per word
+ * dominates the time of large dumps.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "dump.h"
+
+#define ROW 8
+
+typedef struct {
+    FILE *fp;
+    size_t len;
+    int err;
+    char buf[1u << 16u];
+} DumpBuf;
+
+static DumpBuf *out_open(FILE *fp) {
+    DumpBuf *b = malloc(sizeof(DumpBuf));
+
+    if (b) {
+        b->fp = fp;
+        b->len = 0;
+        b->err = 0;
+    }
+    return b;
+}
+
+static void out_flush(DumpBuf *b) {
+    if (b->len && fwrite(b->buf, 1, b->len, b->fp) != b->len)
+        b->err = 1;
+    b->len = 0;
+}
+
+/* Pointer to n free bytes */
+static char *out_room(DumpBuf *b, size_t n) {
+    if (b->len + n > sizeof(b->buf))
+        out_flush(b);
+    return b->buf + b->len;
+}
+
+static void out_str(DumpBuf *b, const char *s) {
+    size_t n = strlen(s);
+
+    memcpy(out_room(b, n), s, n);
+    b->len += n;
+}
+
+static char *put_str(char *p, const char *s) {
+    while (*s)
+        *p++ = *s++;
+    return p;
+}
+
+static char *put_hex4(char *p, uint16_t w) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (int shift = 12; shift >= 0; shift -= 4)
+        *p++ = digits[(w >> shift) & 0xfu];
+    return p;
+}
+
+static char *put_int(char *p, int v) {
+    char tmp[8];
+    int n = 0;
+    unsigned u = v < 0 ? -(unsigned) v : (unsigned) v;
+
+    if (v < 0)
+        *p++ = '-';
+    do {
+        tmp[n++] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (n)
+        *p++ = tmp[--n];
+    return p;
+}
+
+static char *put_u16(char *p, uint16_t w) {
+    *p++ = (char) (w & 0xffu);
+    *p++ = (char) (w >> 8u);
+    return p;
+}
+
+/* Rows of ROW words from lo through hi, those of zeros left out with skip_zero */
+static void hex_rows(DumpBuf *b, const hvm_machine *m, int lo, int hi, int skip_zero) {
+    for (int a = lo; a <= hi; a += ROW) {
+        int end = a + ROW - 1 < hi ? a + ROW - 1 : hi;
+        int zero = 1;
+        char *p, *start;
+
+        for (int i = a; skip_zero && i <= end; ++i)
+            zero &= !hvm_read(m, (uint16_t) i);
+        if (skip_zero && zero)
+            continue;
+        p = start = out_room(b, 6 + 5 * ROW + 1);
+        p = put_hex4(p, (uint16_t) a);
+        *p++ = ':';
+        for (int i = a; i <= end; ++i) {
+            *p++ = ' ';
+            p = put_hex4(p, (uint16_t) hvm_read(m, (uint16_t) i));
+        }
+        *p++ = '\n';
+        b->len += (size_t) (p - start);
+    }
+}
+
+int dump_state(const hvm_machine *m, long instrs, int ram, const char *why, FILE *fp) {
+    struct hvm_stats st;
+    time_t now = time(NULL);
+    char when[32];
+    DumpBuf *b;
+
+    hvm_get_stats(m, &st);
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "# dump %s %s\n", why, when);
+    fprintf(fp, "A %d\nD %d\nPC %d\n", hvm_get_reg(m, HVM_REG_A), hvm_get_reg(m, HVM_REG_D),
+            hvm_get_reg(m, HVM_REG_PC));
+    fprintf(fp, "halted %d\ninstrs %ld\nkbd_idle %lu\n", hvm_halted(m), instrs, hvm_kbd_idle(m));
+    if (st.instrs) {
+        fprintf(fp, "a_instrs %lu\nc_instrs %lu\n", st.a_instrs, st.c_instrs);
+        fprintf(fp, "jumps_taken %lu\njumps_not_taken %lu\n", st.jumps_taken, st.jumps_not_taken);
+        fprintf(fp, "ram_reads %lu\nram_writes %lu\n", st.ram_reads, st.ram_writes);
+    }
+    if (ram) {
+        if (!(b = out_open(fp)))
+            return -1;
+        hex_rows(b, m, 0, HVM_RAM_SIZE - 1, 1);
+        out_flush(b);
+        free(b);
+    }
+    return fflush(fp) || ferror(fp) ? -1 : 0;
+}
+
+int dump_format(const char *name) {
+    if (!strcmp(name, "raw"))
+        return DUMP_RAW;
+    if (!strcmp(name, "hex"))
+        return DUMP_HEX;
+    if (!strcmp(name, "json"))
+        return DUMP_JSON;
+    return -1;
+}
+
+int dump_ranges(const char *spec, DumpRange *ranges, int max) {
+    int n = 0;
+    char *end;
+    long lo, hi;
+
+    do {
+        lo = strtol(spec, &end, 0);
+        if (end == spec)
+            return -1;
+        hi = lo;
+        if (*end == '-') {
+            spec = end + 1;
+            hi = strtol(spec, &end, 0);
+            if (end == spec)
+                return -1;
+        }
+        if (lo < 0 || hi < lo || hi >= HVM_RAM_SIZE || n == max || (*end && *end != ','))
+            return -1;
+        ranges[n].lo = (uint16_t) lo;
+        ranges[n].hi = (uint16_t) hi;
+        ++n;
+        spec = end + 1;
+    } while (*end);
+    return n;
+}
+
+static void raw(DumpBuf *b, const hvm_machine *m, const DumpRange *ranges, int n) {
+    char *p = out_room(b, 16);
+
+    p = put_str(p, "HVMS");
+    p = put_u16(p, (uint16_t) hvm_get_reg(m, HVM_REG_A));
+    p = put_u16(p, (uint16_t) hvm_get_reg(m, HVM_REG_D));
+    p = put_u16(p, (uint16_t) hvm_get_reg(m, HVM_REG_PC));
+    p = put_u16(p, (uint16_t) hvm_halted(m));
+    p = put_u16(p, (uint16_t) n);
+    put_u16(p, 0);
+    b->len += 16;
+    for (int r = 0; r < n; ++r) {
+        p = out_room(b, 4);
+        p = put_u16(p, ranges[r].lo);
+        put_u16(p, (uint16_t) (ranges[r].hi - ranges[r].lo + 1));
+        b->len += 4;
+        for (int a = ranges[r].lo; a <= ranges[r].hi; ++a) {
+            put_u16(out_room(b, 2), (uint16_t) hvm_read(m, (uint16_t) a));
+            b->len += 2;
+        }
+    }
+}
+
+static void hex(DumpBuf *b, const hvm_machine *m, const DumpRange *ranges, int n) {
+    char *p = out_room(b, 64), *start = p;
+
+    p = put_hex4(put_str(p, "A "), (uint16_t) hvm_get_reg(m, HVM_REG_A));
+    p = put_hex4(put_str(p, "\nD "), (uint16_t) hvm_get_reg(m, HVM_REG_D));
+    p = put_hex4(put_str(p, "\nPC "), (uint16_t) hvm_get_reg(m, HVM_REG_PC));
+    p = put_str(p, hvm_halted(m) ? "\nhalted 1\n" : "\nhalted 0\n");
+    b->len += (size_t) (p - start);
+    for (int r = 0; r < n; ++r)
+        hex_rows(b, m, ranges[r].lo, ranges[r].hi, 0);
+}
+
+static void json(DumpBuf *b, const hvm_machine *m, const DumpRange *ranges, int n) {
+    char *p = out_room(b, 64), *start = p;
+
+    p = put_int(put_str(p, "{\"a\": "), hvm_get_reg(m, HVM_REG_A));
+    p = put_int(put_str(p, ", \"d\": "), hvm_get_reg(m, HVM_REG_D));
+    p = put_int(put_str(p, ", \"pc\": "), hvm_get_reg(m, HVM_REG_PC));
+    b->len += (size_t) (p - start);
+    out_str(b, hvm_halted(m) ? ", \"halted\": true, \"ranges\": [" : ", \"halted\": false, \"ranges\": [");
+    for (int r = 0; r < n; ++r) {
+        p = start = out_room(b, 32);
+        p = put_int(put_str(p, r ? ",\n  {\"start\": " : "\n  {\"start\": "), ranges[r].lo);
+        p = put_str(p, ", \"words\": [");
+        b->len += (size_t) (p - start);
+        for (int a = ranges[r].lo; a <= ranges[r].hi; ++a) {
+            p = start = out_room(b, 8);
+            if (a != ranges[r].lo)
+                *p++ = ',';
+            p = put_int(p, hvm_read(m, (uint16_t) a));
+            b->len += (size_t) (p - start);
+        }
+        out_str(b, "]}");
+    }
+    out_str(b, "\n]}\n");
+}
+
+int dump_snapshot(const hvm_machine *m, enum dump_format fmt, const DumpRange *ranges, int n, FILE *fp) {
+    DumpBuf *b = out_open(fp);
+    int err;
+
+    if (!b)
+        return -1;
+    switch (fmt) {
+        case DUMP_RAW:
+            raw(b, m, ranges, n);
+            break;
+        case DUMP_HEX:
+            hex(b, m, ranges, n);
+            break;
+        case DUMP_JSON:
+            json(b, m, ranges, n);
+            break;
+    }
+    out_flush(b);
+    err = b->err || fflush(fp) ? -1 : 0;
+    free(b);
+    return err;
+}
@@ -0,0 +1,51 @@
+/*
+ * dump.h
+ */
+
+#ifndef HVM_DUMP_H
+#define HVM_DUMP_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "hvm.h"
+
+/*
+ * Append the state of m to fp as text: a '# dump' line with the reason,
+ * then 'name value' lines for the registers, halted, instrs run so far
+ * and the counts of hvm_get_stats(), and with ram the RAM as hex rows of
+ * 8 words 'addr: w w ...', rows of zeros left out. Returns 0, -1 if the
+ * write failed.
+ */
+int dump_state(const hvm_machine *m, long instrs, int ram, const char *why, FILE *fp);
+
+enum dump_format {
+    DUMP_RAW,       // binary image, see dump_snapshot()
+    DUMP_HEX,       // register lines, then 'addr: w w ...' rows of 8 words
+    DUMP_JSON       // {"a", "d", "pc", "halted", "ranges": [{"start", "words"}]}
+};
+
+/* RAM addresses lo through hi */
+typedef struct {
+    uint16_t lo;
+    uint16_t hi;
+} DumpRange;
+
+/* Format by name, raw, hex or json, -1 if none */
+int dump_format(const char *name);
+
+/*
+ * Parse 'lo-hi' or single addresses, separated by commas, into at most
+ * max ranges. Returns their count, -1 if spec is no such list.
+ */
+int dump_ranges(const char *spec, DumpRange *ranges, int max);
+
+/*
+ * Write the registers of m and its RAM in ranges to fp, formatted in
+ * large blocks. The raw image is little endian 16 bit words: the magic
+ * 'HVMS', A, D, PC, halted, the range count and a 0, then per range its
+ * first address, its word count and the words. Returns 0, -1 if the
+ * write failed.
+ */
+int dump_snapshot(const hvm_machine *m, enum dump_format fmt, const DumpRange *ranges, int n, FILE *fp);
+
+#endif //HVM_DUMP_H
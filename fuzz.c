@@ -0,0 +1,145 @@
+/*
+ * fuzz.c
+ *
+ * Persistent fuzzing entry point for libFuzzer, one process runs every
+ * input. The ROM is loaded once and checkpointed, each input forks the
+ * machine from that checkpoint, which drops only the pages the previous
+ * input wrote. Edges between blocks are counted into libFuzzer's extra
+ * counters.
+ *
+ * Set up through the environment:
+ *
+ *   HVM_FUZZ_ROM        .hex image, required
+ *   HVM_FUZZ_SYMBOLS    symbol map
+ *   HVM_FUZZ_FLAGS      hvm_flags
+ *   HVM_FUZZ_STEPS      instrs per input, 1000000 by default
+ *   HVM_FUZZ_RAM        address the input's words are written to, without
+ *                       it they are typed on the keyboard one at a time
+ *   HVM_FUZZ_KEY_STEPS  instrs each key is held down, 1000 by default
+ *
+ * Input is read as big endian words. Built without libFuzzer (HVM_FUZZ_MAIN)
+ * main() runs input files through the same entry point and reports
+ * executions per second and edges seen.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "hvm.h"
+
+#define COVER_SIZE 0x10000
+
+/* libFuzzer picks up counters from this section on its own */
+__attribute__((section("__libfuzzer_extra_counters")))
+static uint8_t cover[COVER_SIZE];
+
+static hvm_machine *fuzz_m;
+static hvm_checkpoint *fuzz_cp;
+static long fuzz_steps = 1000000;
+static long fuzz_key_steps = 1000;
+static long fuzz_ram = -1;
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static long env_long(const char *name, long def) {
+    const char *v = getenv(name);
+
+    return v && *v ? strtol(v, NULL, 0) : def;
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    const char *rom = getenv("HVM_FUZZ_ROM");
+    const char *symbols = getenv("HVM_FUZZ_SYMBOLS");
+    int err;
+
+    (void) argc;
+    (void) argv;
+    fuzz_steps = env_long("HVM_FUZZ_STEPS", fuzz_steps);
+    fuzz_key_steps = env_long("HVM_FUZZ_KEY_STEPS", fuzz_key_steps);
+    fuzz_ram = env_long("HVM_FUZZ_RAM", fuzz_ram);
+
+    if (!rom) {
+        fprintf(stderr, "error: HVM_FUZZ_ROM not set\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!(fuzz_m = hvm_create((unsigned) env_long("HVM_FUZZ_FLAGS", 0)))) {
+        fprintf(stderr, "error: [%s] %s\n", rom, hvm_strerror(HVM_ERR_NOMEM));
+        exit(EXIT_FAILURE);
+    }
+    if ((symbols && (err = hvm_load_symbols(fuzz_m, symbols))) || (err = hvm_load_file(fuzz_m, rom))) {
+        fprintf(stderr, "error: [%s] %s\n", rom, hvm_strerror(err));
+        exit(EXIT_FAILURE);
+    }
+    if (!(fuzz_cp = hvm_checkpoint_create(fuzz_m))) {
+        fprintf(stderr, "error: [%s] %s\n", rom, hvm_strerror(HVM_ERR_NOMEM));
+        exit(EXIT_FAILURE);
+    }
+    hvm_set_coverage(fuzz_m, cover, sizeof(cover));
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    long steps = fuzz_steps;
+
+    hvm_fork(fuzz_m, fuzz_cp);
+    for (size_t i = 0; i < size; i += 2) {
+        int16_t word = (int16_t) (data[i] << 8u | (i + 1 < size ? data[i + 1] : 0));
+
+        if (fuzz_ram >= 0) {
+            hvm_write(fuzz_m, (uint16_t) (fuzz_ram + i / 2), word);
+        } else if (steps > 0) {
+            hvm_write(fuzz_m, HVM_KBD, word);
+            steps -= hvm_run(fuzz_m, steps < fuzz_key_steps ? steps : fuzz_key_steps);
+        }
+    }
+    if (fuzz_ram < 0)
+        hvm_write(fuzz_m, HVM_KBD, 0);
+    if (steps > 0)
+        hvm_run(fuzz_m, steps);
+    return 0;
+}
+
+#ifdef HVM_FUZZ_MAIN
+
+/* Usage: hvm-fuzz [-r N] input... runs every input N times */
+int main(int argc, char *argv[]) {
+    static uint8_t buf[1 << 16];
+    struct timespec t0, t1;
+    long runs = 1, execs = 0, edges = 0;
+    int i = 1;
+    double sec;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    if (argc > 2 && argv[1][0] == '-' && argv[1][1] == 'r') {
+        runs = strtol(argv[2], NULL, 0);
+        i = 3;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (; i < argc; ++i) {
+        size_t len;
+        FILE *fp = fopen(argv[i], "rb");
+
+        if (!fp) {
+            fprintf(stderr, "error: [%s] unable to open file\n", argv[i]);
+            continue;
+        }
+        len = fread(buf, 1, sizeof(buf), fp);
+        fclose(fp);
+        for (long r = 0; r < runs; ++r, ++execs)
+            LLVMFuzzerTestOneInput(buf, len);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (size_t e = 0; e < sizeof(cover); ++e)
+        edges += cover[e] != 0;
+    sec = (double) (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%ld execs in %.3f s, %.0f execs/s, %ld edges\n", execs, sec, sec > 0 ? execs / sec : 0.0, edges);
+    hvm_checkpoint_release(fuzz_cp);
+    hvm_destroy(fuzz_m);
+    return 0;
+}
+
+#endif
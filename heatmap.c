@@ -0,0 +1,129 @@
+/*
+ * heatmap.c
+ *
+ * RAM access histogram and screen heatmap. Addresses are named after the
+ * VM translator's memory segments, the histogram shows which pointers,
+ * statics and stack slots the program keeps going back to.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "heatmap.h"
+
+#define SCREEN_W 512
+#define SCREEN_H 256
+
+static const uint64_t *sort_counts;
+
+/* Bits needed for n, a log2 scale that keeps 0 apart */
+static int bit_len(uint64_t n) {
+    return n ? 64 - __builtin_clzll(n) : 0;
+}
+
+/* Busiest first, then by address */
+static int by_traffic(const void *a, const void *b) {
+    uint16_t x = *(const uint16_t *) a, y = *(const uint16_t *) b;
+    uint64_t tx = sort_counts[x] + sort_counts[HVM_RAM_SIZE + x];
+    uint64_t ty = sort_counts[y] + sort_counts[HVM_RAM_SIZE + y];
+
+    if (tx != ty)
+        return tx < ty ? 1 : -1;
+    return x - y;
+}
+
+/* Segment of addr, with the register or temp index where there is one */
+static void segment(uint16_t addr, char *buf, size_t len) {
+    static const char *pointers[] = {"SP", "LCL", "ARG", "THIS", "THAT"};
+
+    if (addr < 5)
+        snprintf(buf, len, "%s", pointers[addr]);
+    else if (addr < 13)
+        snprintf(buf, len, "temp %d", addr - 5);
+    else if (addr < 16)
+        snprintf(buf, len, "R%d", addr);
+    else if (addr < 256)
+        snprintf(buf, len, "static");
+    else if (addr < 2048)
+        snprintf(buf, len, "stack");
+    else if (addr < HVM_SCREEN)
+        snprintf(buf, len, "heap");
+    else if (addr < HVM_SCREEN + HVM_SCREEN_SIZE)
+        snprintf(buf, len, "screen");
+    else if (addr == HVM_KBD)
+        snprintf(buf, len, "KBD");
+    else
+        snprintf(buf, len, "-");
+}
+
+int heatmap_write(const uint64_t *counts, unsigned every, const char *path) {
+    uint16_t *order = malloc(sizeof(uint16_t) * HVM_RAM_SIZE);
+    uint64_t reads = 0, writes = 0, cum = 0;
+    int n = 0;
+    char seg[16];
+    FILE *fp;
+
+    if (!order || !(fp = fopen(path, "w"))) {
+        free(order);
+        return -1;
+    }
+
+    for (int a = 0; a < HVM_RAM_SIZE; ++a) {
+        reads += counts[a];
+        writes += counts[HVM_RAM_SIZE + a];
+        if (counts[a] || counts[HVM_RAM_SIZE + a])
+            order[n++] = a;
+    }
+    sort_counts = counts;
+    qsort(order, n, sizeof(uint16_t), by_traffic);
+
+    fprintf(fp, "# %llu reads and %llu writes sampled, 1 in %u, at %d addresses\n", (unsigned long long) reads,
+            (unsigned long long) writes, every ? every : 1, n);
+    fprintf(fp, "#%15s %16s %7s %7s %6s  %s\n", "reads", "writes", "%", "cum%", "addr", "segment");
+    for (int i = 0; i < n; ++i) {
+        uint16_t a = order[i];
+        uint64_t total = counts[a] + counts[HVM_RAM_SIZE + a];
+
+        cum += total;
+        segment(a, seg, sizeof(seg));
+        fprintf(fp, "%16llu %16llu %6.2f%% %6.2f%% %6u  %s\n", (unsigned long long) counts[a],
+                (unsigned long long) counts[HVM_RAM_SIZE + a], 100.0 * total / (reads + writes),
+                100.0 * cum / (reads + writes), a, seg);
+    }
+
+    fclose(fp);
+    free(order);
+    return 0;
+}
+
+int heatmap_image(const uint64_t *counts, const char *path) {
+    const uint64_t *reads = counts + HVM_SCREEN, *writes = counts + HVM_RAM_SIZE + HVM_SCREEN;
+    uint64_t max = 0;
+    int scale;
+    unsigned char row[SCREEN_W * 3];
+    FILE *fp = fopen(path, "wb");
+
+    if (!fp)
+        return -1;
+    for (int w = 0; w < HVM_SCREEN_SIZE; ++w) {
+        max = reads[w] > max ? reads[w] : max;
+        max = writes[w] > max ? writes[w] : max;
+    }
+
+    scale = bit_len(max) ? bit_len(max) : 1;
+
+    fprintf(fp, "P6\n%d %d\n255\n", SCREEN_W, SCREEN_H);
+    for (int y = 0; y < SCREEN_H; ++y) {
+        for (int x = 0; x < SCREEN_W; ++x) {
+            int w = y * (SCREEN_W / 16) + x / 16;
+
+            row[3 * x] = (unsigned char) (255 * bit_len(writes[w]) / scale);
+            row[3 * x + 1] = (unsigned char) (255 * bit_len(reads[w]) / scale);
+            row[3 * x + 2] = 0;
+        }
+        fwrite(row, 1, sizeof(row), fp);
+    }
+
+    if (fclose(fp))
+        return -1;
+    return 0;
+}
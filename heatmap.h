@@ -0,0 +1,26 @@
+/*
+ * heatmap.h
+ */
+
+#ifndef HVM_HEATMAP_H
+#define HVM_HEATMAP_H
+
+#include <stdint.h>
+#include "hvm.h"
+
+/*
+ * Write the RAM access histogram to path, counts being the samples taken
+ * with hvm_set_heatmap(), one in every. Every address sampled is listed
+ * with its reads and writes, busiest first, and the VM translator segment
+ * it lies in. Returns 0, -1 if path could not be written.
+ */
+int heatmap_write(const uint64_t *counts, unsigned every, const char *path);
+
+/*
+ * Write the screen region's accesses to path as a 512x256 binary PPM, a
+ * pixel per screen bit: writes red, reads green, log2 scaled to the
+ * busiest word. Returns 0, -1 if path could not be written.
+ */
+int heatmap_image(const uint64_t *counts, const char *path);
+
+#endif //HVM_HEATMAP_H
@@ -30,6 +30,15 @@ enum h_opcodes {
     COMP_A              = 0x3B0,
     COMP_M              = 0x3F0,
     COMP_D_OR_M         = 0x3D5,
+    /* Extended ALU, 101 prefixed instead of 111, decoded only in extended ISA mode */
+    COMP_A_SHR          = 0x280,
+    COMP_D_SHR          = 0x290,
+    COMP_A_SHL          = 0x2A0,
+    COMP_D_SHL          = 0x2B0,
+    COMP_M_SHR          = 0x2C0,
+    COMP_M_SHL          = 0x2E0,
+    COMP_D_MUL_A        = 0x282,
+    COMP_D_MUL_M        = 0x2C2,
     DEST_M              = 0x1,
     DEST_D              = 0x2,
     DEST_MD             = 0x3,
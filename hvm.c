@@ -2,1931 +2,549 @@
  * hvm.c
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <memory.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <sys/stat.h>
-#include "hopcodes.h"
+#include <time.h>
+#include <unistd.h>
+#include "batch.h"
+#include "callgraph.h"
+#include "checkpoint.h"
+#include "coverage.h"
+#include "dump.h"
+#include "heatmap.h"
+#include "hwstats.h"
+#include "live.h"
+#include "hvm.h"
+#include "multi.h"
+#include "profile.h"
 
 #define errprint(format, ...) fprintf (stderr, format, __VA_ARGS__);
 
-/* read Most Significant Bit */
-#define read_msb(n) ( ((n) << 8u) | ((n) >> 8u) )
+/* Memory snapshot, the banner and ROM words paired with RAM words */
+static void snapshot(const hvm_machine *);
+static void snapshot_write(const hvm_machine *, FILE *fp);
 
-/* End of signature */
-#define EOS 0xFFFF 
+/* Execution statistics, --stats */
+static void stats_report(const hvm_machine *, double sec);
 
-/* payload offset */
-#define P_OFF 0x8 
-
-/* 32KB */
-#define ROM_SIZE 32768 
-
-/* 16KB */
-#define RAM_SIZE 16384
-
-#define EmitComp(n) ((n & 0xFFC0u) >> 6u)
-#define EmitDest(n) ((n & 0x38u) >> 3u)
-#define EmitJmp(n) (n & 0x07u)
-
-typedef uint16_t u16;
-typedef uint8_t u8;
-
-typedef struct {
-    u16 comp:10;
-    u8 dest:3;
-    u8 jmp:3;
-    int16_t A_REG:16;
-    int16_t D_REG:16;
-    int state;
-    int pc;
-} HVMData;
-
-enum hvm_state {
-    hvm_fetch,
-    hvm_decode,
-    hvm_execute
-};
-
-/* Memory */
-static u16 ROM[ROM_SIZE];
-static int16_t RAM[RAM_SIZE];
-
-/* Current state of machine */
-static int running = 1;
+static int util_fd_isreg(const char *filename);
 
-/* Initialize VM */
-static void vm_init(char *);
+/* Execution trace, --trace, dumped on halt and on fatal signals */
+static hvm_trace *trace;
+static int trace_fd = -1;
 
-/* VM State: Fetch, Decode, Execute */
-static u16 fetch(HVMData *);
-static void decode(u16, HVMData *);
-static void execute(HVMData *);
+static void trace_write(void);
+static void trace_signal(int sig);
 
-/* Memory snapshot */
-static void snapshot(HVMData *);
+/* Set by SIGUSR1, SIGINT and SIGTERM, acted on between run slices */
+static volatile sig_atomic_t dump_pending;
+static volatile sig_atomic_t stop_pending;
 
-static int util_fd_isreg(const char *filename);
+static void dump_signal(int sig);
+static void stop_signal(int sig);
+static void dump_write(const hvm_machine *m, long instrs, int ram, const char *why, const char *path);
 
 
 int main(int argc, char *argv[]) {
     int opt;
-
-    const char *usage = "Usage: ./hvm [file.hex]";
-    while ((opt = getopt(argc, argv, "h:")) != -1) {
+    int err;
+    unsigned flags = 0;
+    const char *symbols = NULL;
+    const char *manifest = NULL;
+    int jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int lockstep = 0;
+    int multi = 0;
+    long prefix = 0;
+    int stats = 0;
+    const char *profile = NULL;
+    uint64_t *entries = NULL;
+    const char *calls = NULL;
+    const char *folded = NULL;
+    callgraph *g = NULL;
+    const char *trace_path = NULL;
+    long trace_kb = 64;
+    const char *cover_path = NULL;
+    const char *cover_report = NULL;
+    uint8_t *cover_bits = NULL;
+    const char *heat_path = NULL;
+    const char *heat_image = NULL;
+    unsigned heat_every = 1;
+    long heat_lo = 0, heat_hi = HVM_RAM_SIZE - 1;
+    uint64_t *heat = NULL;
+    int hw = 0;
+    hwstats *hws = NULL;
+    long instrs = 0;
+    const char *live_name = NULL;
+    long slice = 1L << 20;
+    live *lv = NULL;
+    const char *dump_path = NULL;
+    int dump_ram = 0;
+    char dump_default[32];
+    const char *snap_path = NULL;
+    int snap_format = -1;
+    DumpRange snap_ranges[64] = {{0, HVM_RAM_SIZE - 1}};
+    int snap_n = 1;
+    FILE *snap;
+    const char *ckpt_path = "hvm.ckpt";
+    long ckpt_every = 0;
+    long ckpt_next = -1;
+    const char *restore = NULL;
+    long quantum;
+    long restored = 0;
+    char *end;
+    struct timespec t0, t1;
+    hvm_machine *m;
+
+    const struct option longopts[] = {
+            {"batch", required_argument, NULL, 'b'},
+            {"jobs",  required_argument, NULL, 'j'},
+            {"lockstep", no_argument,    NULL, 'l'},
+            {"multi", no_argument,       NULL, 'm'},
+            {"prefix", required_argument, NULL, 'p'},
+            {"stats", no_argument,       NULL, 'S'},
+            {"profile", required_argument, NULL, 'P'},
+            {"callgraph", required_argument, NULL, 'C'},
+            {"folded", required_argument, NULL, 'F'},
+            {"trace", required_argument, NULL, 'T'},
+            {"trace-size", required_argument, NULL, 'Z'},
+            {"coverage", required_argument, NULL, 'V'},
+            {"coverage-report", required_argument, NULL, 'R'},
+            {"heatmap", required_argument, NULL, 'H'},
+            {"heat-image", required_argument, NULL, 'I'},
+            {"heat-every", required_argument, NULL, 'N'},
+            {"heat-range", required_argument, NULL, 'A'},
+            {"hwstats", no_argument,     NULL, 'W'},
+            {"live", required_argument,  NULL, 'L'},
+            {"slice", required_argument, NULL, 'E'},
+            {"dump", required_argument,  NULL, 'U'},
+            {"dump-ram", no_argument,    NULL, 'M'},
+            {"snapshot", required_argument, NULL, 'O'},
+            {"snapshot-format", required_argument, NULL, 'f'},
+            {"snapshot-range", required_argument, NULL, 'r'},
+            {"checkpoint", required_argument, NULL, 'k'},
+            {"checkpoint-every", required_argument, NULL, 'K'},
+            {"restore", required_argument, NULL, 'X'},
+            {NULL, 0,                    NULL, 0}
+    };
+    const char *usage = "Usage: ./hvm [-n] [-e] [-x] [-s file.map] [--stats] [--hwstats] [--profile out] [--callgraph out] [--folded out]\n"
+                        "             [--trace out [--trace-size KB]] [--coverage file] [--coverage-report out]\n"
+                        "             [--heatmap out] [--heat-image out.ppm] [--heat-every N] [--heat-range lo-hi]\n"
+                        "             [--live /name] [--slice N] [--dump file [--dump-ram]]\n"
+                        "             [--snapshot out] [--snapshot-format raw|hex|json] [--snapshot-range lo-hi,...]\n"
+                        "             [--checkpoint-every N [--checkpoint file]] [--restore file] [file.hex]\n"
+                        "       ./hvm [-n] [-e] [-x] [-s file.map] [-j N] [-l] [-p N] --batch manifest\n"
+                        "       ./hvm [-n] [-e] [-x] [-s file.map] --multi cpu0.hex cpu1.hex ...\n"
+                        "  -n  do not fuse VM translator call/return and stack sequences\n"
+                        "  -x  extended ISA, 101 prefixed C instrs for shifts and multiply\n"
+                        "  -e  run Jack OS Math and Memory routines natively, needs -s\n"
+                        "  -s  symbol map, one 'name address' pair per line\n"
+                        "      --stats  report instrs by class, wall time and MIPS on stderr\n"
+                        "      --hwstats  report host cycles, instructions, branch and L1 misses of the run on stderr\n"
+                        "      --profile out  write executions per ROM address, hottest first, to out\n"
+                        "      --callgraph out  write inclusive and exclusive instrs per function to out\n"
+                        "      --folded out  write call stacks with their instrs to out, for flamegraph tools\n"
+                        "      --trace out  write the last blocks run to out on halt or fatal signal, see hvm-trace\n"
+                        "      --trace-size KB  size of the trace ring, 64 by default\n"
+                        "      --coverage file  merge the blocks and jump directions run into the bitmap file\n"
+                        "      --coverage-report out  write words run, jumps by direction and what was missed to out\n"
+                        "      --heatmap out  write sampled reads and writes per RAM address, busiest first, to out\n"
+                        "      --heat-image out.ppm  write the screen region's sampled accesses as an image\n"
+                        "      --heat-every N  sample one in N RAM accesses, all by default\n"
+                        "      --heat-range lo-hi  sample accesses to these addresses only\n"
+                        "      --live /name  share RAM and registers through POSIX shared memory, see live.h\n"
+                        "      --slice N  run N instrs, then on to a block entry, between updates and signal checks\n"
+                        "      --dump file  where SIGUSR1, SIGINT and SIGTERM dump registers and counts, hvm-PID.dump by default\n"
+                        "      --dump-ram  dump the RAM as well\n"
+                        "      --snapshot out  write the final snapshot to out instead of stdout\n"
+                        "      --snapshot-format F  raw binary image, hex dump or json instead of the banner\n"
+                        "      --snapshot-range lo-hi,...  RAM ranges the formats hold, all of RAM by default\n"
+                        "      --checkpoint-every N  save the machine to the checkpoint file every N instrs and on SIGINT or SIGTERM\n"
+                        "      --checkpoint file  checkpoint file, hvm.ckpt by default\n"
+                        "      --restore file  continue from a checkpoint of the same ROM\n"
+                        "  -b, --batch  run every 'rom.hex [input] [max_steps] [from-to]' line of manifest\n"
+                        "  -j, --jobs   number of batch worker threads, one per CPU by default\n"
+                        "  -l, --lockstep  run batch jobs on the same ROM and budget in lockstep groups\n"
+                        "  -p, --prefix run each batch ROM N instrs once, jobs fork from there with their input\n"
+                        "  -m, --multi  one CPU per file.hex on its own thread, talking through mailboxes at 0x6100";
+    while ((opt = getopt_long(argc, argv, "h:nexs:b:j:lmp:", longopts, NULL)) != -1) {
         switch (opt) {
             case 'h':
                 printf("%s\n", usage);
                 break;
-            default: /* '?' */
-                errprint("Usage: %s [file.hex]\n", argv[0])
-        }
-    }
-
-    if (argv[optind] == NULL || strlen(argv[optind]) == 0) {
-        errprint("error: [%s] No such file or directory\n", argv[optind])
-        exit(EXIT_FAILURE);
-    }
-
-    vm_init(argv[optind]);
-
-    u16 instr;
-    HVMData hdt = {
-            .state=hvm_fetch,
-            .pc=0};
-
-    while (running) {
-        // Fetch State
-        instr = fetch(&hdt);
-
-        if (instr == EOS)
-            break;
-        // Decode State
-        decode(instr, &hdt);
-        if (hdt.state == hvm_execute) {
-            hdt.state = hvm_fetch;
-            // Execute State
-            execute(&hdt);
-        }
-    }
-    snapshot(&hdt);
-}
-
-static void snapshot(HVMData *hdt) {
-    char *msg = " _   ___      ____  __   \n"
-                "| | | |\\ \\   / |  \\/  |  \n"
-                "| |_| | \\ \\ / /| |\\/| |  \n"
-                "|  _  |  \\ V / | |  | |  \n"
-                "|_| |_|   \\_/  |_|  |_|  \n"
-                "                          \n"
-                "Memory Snapshot \n"
-                "****************************************\n"
-                "*           *            *    CPU      *\n"
-                "*           *            ***************\n"
-                "*   ROM     *   RAM      |  A REG [%d]  \n"
-                "*           *            |--------------\n"
-                "*           *            |  D REG [%d]  \n"
-                "*           *            |--------------\n"
-                "*           *            |  PC [%d]     \n";
-
-    char *memories = "_________________________\n"
-                "|  %x             %d     \n";
-    printf(msg, hdt->A_REG, hdt->D_REG, hdt->pc);
-    for (int i = 0; ROM[i] ^ 0xffff; ++i) {
-        printf(memories, ROM[i], RAM[i]);
-    }
-
-}
-
-
-static void vm_init(char *arg) {
-    u16 buff;
-    int ind = 0;
-
-    FILE *hexfp = NULL;
-
-    if (util_fd_isreg(arg) > 0) {
-        hexfp = fopen(arg, "rb");
-        if (!hexfp) {
-            errprint("error: [%s] unable to open file\n", arg)
-            exit(EXIT_FAILURE);
-        }
-    } else {
-        errprint("error: [%s] No such file or directory\n", arg)
-        exit(EXIT_FAILURE);
-    }
-
-    memset(RAM, 0, sizeof(RAM));
-    memset(ROM, 0, sizeof(ROM));
-
-    // jump program offset
-    fseek(hexfp, P_OFF, SEEK_SET);
-    while (fread(&buff, sizeof(buff), 1, hexfp) != 0) {
-        ROM[ind++] = read_msb(buff);
-    }
-    // end-of-program signature
-    ROM[ind] = EOS;
-    fclose(hexfp);
-}
-
-static u16 fetch(HVMData *hdt) {
-    return ROM[hdt->pc++];
-}
-
-static void decode(u16 instr, HVMData *hdt) {
-    // check instr first significant 3 bits.If 111 it is C instr,otherwise A instr
-    if (((instr & 0xE000u) >> 13u) ^ 0x7u) {
-        hdt->state = hvm_decode;
-        hdt->A_REG = instr;
-        return;
-    }
-    // extract comp,dest,jmp parts of instr
-    hdt->comp = EmitComp(instr);     // 1111111111000000
-    hdt->dest = EmitDest(instr);     // 0000000000111000
-    hdt->jmp =  EmitJmp(instr);      // 0000000000000111
-
-    // turn machine state execute
-    hdt->state = hvm_execute;
-}
-
-static int util_fd_isreg(const char *filename) {
-    struct stat st;
-
-    if (stat(filename, &st))
-        return -1;
-
-    return S_ISREG(st.st_mode);
-}
-
-
-static void execute(HVMData *hdt) {
-    if (!(hdt->jmp ^ 0x0)) {
-        switch (hdt->comp) {
-            case COMP_ZERO:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = 0x0;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = 0x0;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = 0x0;
-                        RAM[hdt->A_REG] = 0x0;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = 0x0;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = 0x0;
-                        hdt->A_REG = 0x0;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = 0x0;
-                        hdt->A_REG = 0x0;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = 0x0;
-                        hdt->A_REG = 0x0;
-                        hdt->D_REG = 0x0;
-                        break;
-                    default:
-                        break;
-                }
-
-                break;
-            case COMP_ONE:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = 0x1;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = 0x1;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = 0x1;
-                        RAM[hdt->A_REG] = 0x1;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = 0x1;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = 0x1;
-                        hdt->A_REG = 0x1;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = 0x1;
-                        hdt->A_REG = 0x1;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = 0x1;
-                        hdt->A_REG = 0x1;
-                        hdt->D_REG = 0x1;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_MINUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = -1;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = -1;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = -1;
-                        RAM[hdt->A_REG] = -1;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = -1;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = -1;
-                        hdt->A_REG = -1;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = -1;
-                        hdt->A_REG = -1;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = -1;
-                        hdt->A_REG = -1;
-                        hdt->D_REG = -1;
-                        break;
-                    default:
-                        break;
-                }
-
-                break;
-            case COMP_D:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        break;
-                    case DEST_MD:
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        hdt->D_REG = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-
-                break;
-            case COMP_NOT_D:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = ~(hdt->D_REG);
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = ~(hdt->D_REG);
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = ~(hdt->D_REG);
-                        RAM[hdt->A_REG] = ~(hdt->D_REG);
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = ~(hdt->D_REG);
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = ~(hdt->D_REG);
-                        hdt->A_REG = ~(hdt->D_REG);
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = ~(hdt->D_REG);
-                        hdt->A_REG = ~(hdt->D_REG);
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = ~(hdt->D_REG);
-                        hdt->A_REG = ~(hdt->D_REG);
-                        hdt->D_REG = ~(hdt->D_REG);
-                        break;
-                    default:
-                        break;
-                }
+            case 'n':
+                flags |= HVM_NO_FUSE;
                 break;
-            case COMP_NOT_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = ~(hdt->A_REG);
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = ~(hdt->A_REG);
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = ~(hdt->A_REG);
-                        RAM[hdt->A_REG] = ~(hdt->A_REG);
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = ~(hdt->A_REG);
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = ~(hdt->A_REG);
-                        hdt->A_REG = ~(hdt->A_REG);
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = ~(hdt->A_REG);
-                        hdt->A_REG = ~(hdt->A_REG);
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = ~(hdt->A_REG);
-                        hdt->A_REG = ~(hdt->A_REG);
-                        hdt->D_REG = ~(hdt->A_REG);
-                        break;
-                    default:
-                        break;
-                }
+            case 'e':
+                flags |= HVM_EMULATE_OS;
                 break;
-            case COMP_MINUS_D:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = -hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = -hdt->D_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = -hdt->D_REG;
-                        RAM[hdt->A_REG] = -hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = -hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = -hdt->D_REG;
-                        hdt->A_REG = -hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = -hdt->D_REG;
-                        hdt->A_REG = -hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = -hdt->D_REG;
-                        hdt->A_REG = -hdt->D_REG;
-                        hdt->D_REG = -hdt->D_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'x':
+                flags |= HVM_EXTENDED;
                 break;
-            case COMP_MINUS_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = -hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = -hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = -hdt->A_REG;
-                        RAM[hdt->A_REG] = -hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = -hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = -hdt->A_REG;
-                        hdt->A_REG = -hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = -hdt->A_REG;
-                        hdt->A_REG = -hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = -hdt->A_REG;
-                        hdt->A_REG = -hdt->A_REG;
-                        hdt->D_REG = -hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 's':
+                symbols = optarg;
                 break;
-            case COMP_D_PLUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = ++hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        ++hdt->D_REG;
-                        break;
-                    case DEST_MD:
-                        ++hdt->D_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = ++hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = ++hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        ++hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = ++hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'b':
+                manifest = optarg;
                 break;
-            case COMP_A_PLUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = ++hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = ++hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = ++hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        ++hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = ++hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = ++hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = ++hdt->A_REG;
-                        hdt->D_REG = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'j':
+                jobs = atoi(optarg);
                 break;
-            case COMP_D_MINUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = --hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        --hdt->D_REG;
-                        break;
-                    case DEST_MD:
-                        --hdt->D_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = --hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = --hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        --hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = --hdt->D_REG;
-                        hdt->A_REG = hdt->D_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'l':
+                lockstep = 1;
                 break;
-            case COMP_A_MINUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = --hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = --hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = --hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        --hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = --hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = --hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = --hdt->A_REG;
-                        hdt->D_REG = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'm':
+                multi = 1;
                 break;
-            case COMP_D_PLUS_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG + hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG += hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG += hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG + hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG += hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG + hdt->A_REG;
-                        hdt->A_REG += hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG += hdt->A_REG;
-                        hdt->A_REG += hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG + hdt->A_REG;
-                        hdt->A_REG += hdt->D_REG;
-                        hdt->D_REG += hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'p':
+                prefix = strtol(optarg, NULL, 0);
                 break;
-            case COMP_D_MINUS_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG - hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG -= hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG -= hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG - hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG - hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG - hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG - hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG -= hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG - hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG - hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG - hdt->A_REG;
-                        hdt->D_REG -= hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'S':
+                stats = 1;
                 break;
-            case COMP_A_MINUS_D:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->A_REG - hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = hdt->A_REG - hdt->D_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = hdt->A_REG - hdt->D_REG;
-                        RAM[hdt->A_REG] = hdt->A_REG - hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG -= hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->A_REG - hdt->D_REG;
-                        hdt->A_REG -= hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = hdt->A_REG - hdt->D_REG;
-                        hdt->A_REG -= hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->A_REG - hdt->D_REG;
-                        hdt->A_REG -= hdt->D_REG;
-                        hdt->D_REG = hdt->A_REG - hdt->D_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'W':
+                hw = 1;
                 break;
-            case COMP_D_AND_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG & hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG &= hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG &= hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG & hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG & hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG & hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG & hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG &= hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG & hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG & hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG & hdt->A_REG;
-                        hdt->D_REG &= hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'L':
+                live_name = optarg;
                 break;
-            case COMP_D_OR_A:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG | hdt->A_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG |= hdt->A_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG |= hdt->A_REG;
-                        RAM[hdt->A_REG] = hdt->D_REG | hdt->A_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG | hdt->A_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG | hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG | hdt->A_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG |= hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG | hdt->A_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG | hdt->A_REG;
-                        hdt->A_REG = hdt->D_REG | hdt->A_REG;
-                        hdt->D_REG |= hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'E':
+                slice = strtol(optarg, NULL, 0);
                 break;
-            case COMP_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = RAM[hdt->A_REG];
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        hdt->D_REG = RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'U':
+                dump_path = optarg;
                 break;
-            case COMP_NOT_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = ~RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = ~RAM[hdt->A_REG];
-                        hdt->A_REG = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = ~RAM[hdt->A_REG];
-                        hdt->A_REG = ~RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = ~RAM[hdt->A_REG];
-                        hdt->A_REG = ~RAM[hdt->A_REG];
-                        hdt->D_REG = ~RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'M':
+                dump_ram = 1;
                 break;
-            case COMP_MINUS_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = -RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = -RAM[hdt->A_REG];
-                        hdt->A_REG = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = -RAM[hdt->A_REG];
-                        hdt->A_REG = -RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = -RAM[hdt->A_REG];
-                        hdt->A_REG = -RAM[hdt->A_REG];
-                        hdt->D_REG = -RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'k':
+                ckpt_path = optarg;
                 break;
-            case COMP_M_PLUS_1:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        ++RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = ++RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = ++RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = ++RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        ++RAM[hdt->A_REG];
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = ++RAM[hdt->A_REG];
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        ++RAM[hdt->A_REG];
-                        hdt->A_REG = RAM[hdt->A_REG];
-                        hdt->D_REG = RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'K':
+                ckpt_every = strtol(optarg, NULL, 0);
                 break;
-            case COMP_D_PLUS_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG + RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG += RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG += RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = hdt->D_REG + RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG + RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG + RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG + RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG += RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG + RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG + RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG + RAM[hdt->A_REG];
-                        hdt->D_REG += RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'X':
+                restore = optarg;
                 break;
-            case COMP_D_MINUS_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG - RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG -= RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG -= RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = hdt->D_REG - RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG - RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG - RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG - RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG -= RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG - RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG - RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG - RAM[hdt->A_REG];
-                        hdt->D_REG -= RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'O':
+                snap_path = optarg;
                 break;
-            case COMP_M_MINUS_D:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] -= hdt->D_REG;
-                        break;
-                    case DEST_D:
-                        hdt->D_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        RAM[hdt->A_REG] -= hdt->D_REG;
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] -= hdt->D_REG;
-                        hdt->A_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        hdt->A_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] -= hdt->D_REG;
-                        hdt->A_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        hdt->D_REG = RAM[hdt->A_REG] - hdt->D_REG;
-                        break;
-                    default:
-                        break;
+            case 'f':
+                if ((snap_format = dump_format(optarg)) < 0) {
+                    errprint("error: [%s] unknown snapshot format\n", optarg)
+                    exit(EXIT_FAILURE);
                 }
                 break;
-            case COMP_D_AND_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG & RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG &= RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG &= RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = hdt->D_REG & RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG & RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG & RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG & RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG &= RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG & RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG & RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG & RAM[hdt->A_REG];
-                        hdt->D_REG &= RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
+            case 'r':
+                if ((snap_n = dump_ranges(optarg, snap_ranges, 64)) < 0) {
+                    errprint("error: [%s] not a list of RAM ranges\n", optarg)
+                    exit(EXIT_FAILURE);
                 }
                 break;
-            case COMP_D_OR_M:
-                switch (hdt->dest) {
-                    case DEST_M:
-                        RAM[hdt->A_REG] = hdt->D_REG | RAM[hdt->A_REG];
-                        break;
-                    case DEST_D:
-                        hdt->D_REG |= RAM[hdt->A_REG];
-                        break;
-                    case DEST_MD:
-                        hdt->D_REG |= RAM[hdt->A_REG];
-                        RAM[hdt->A_REG] = hdt->D_REG | RAM[hdt->A_REG];
-                        break;
-                    case DEST_A:
-                        hdt->A_REG = hdt->D_REG | RAM[hdt->A_REG];
-                        break;
-                    case DEST_AM:
-                        RAM[hdt->A_REG] = hdt->D_REG | RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG | RAM[hdt->A_REG];
-                        break;
-                    case DEST_AD:
-                        hdt->D_REG |= RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG | RAM[hdt->A_REG];
-                        break;
-                    case DEST_AMD:
-                        RAM[hdt->A_REG] = hdt->D_REG | RAM[hdt->A_REG];
-                        hdt->A_REG = hdt->D_REG | RAM[hdt->A_REG];
-                        hdt->D_REG |= RAM[hdt->A_REG];
-                        break;
-                    default:
-                        break;
-                }
+            case 'P':
+                profile = optarg;
                 break;
-            default:
-                running = 0;
+            case 'C':
+                calls = optarg;
                 break;
-        }
-    } else {
-        switch (hdt->comp) {
-            case COMP_ZERO:
-                switch (hdt->jmp) {
-                    case JGT:
-                    case JLT:
-                    case JNE:
-                        break;
-                    case JEQ:
-                    case JGE:
-                    case JLE:
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'F':
+                folded = optarg;
                 break;
-            case COMP_ONE:
-                switch (hdt->jmp) {
-                    case JEQ:
-                    case JLT:
-                        break;
-                    case JGT:
-                    case JGE:
-                    case JNE:
-                    case JLE:
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'T':
+                trace_path = optarg;
                 break;
-            case COMP_MINUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                    case JEQ:
-                    case JGE:
-                        break;
-                    case JLT:
-                    case JNE:
-                    case JLE:
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-
+            case 'Z':
+                trace_kb = strtol(optarg, NULL, 0);
                 break;
-            case COMP_D:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (hdt->D_REG > 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JEQ:
-                        if (hdt->D_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (hdt->D_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (hdt->D_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (hdt->D_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (hdt->D_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'V':
+                cover_path = optarg;
                 break;
-            case COMP_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (hdt->A_REG > 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JEQ:
-                        if (hdt->A_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (hdt->A_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (hdt->A_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (hdt->A_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (hdt->A_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-
+            case 'R':
+                cover_report = optarg;
                 break;
-            case COMP_NOT_D:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (~hdt->D_REG > 0)
-                            hdt->pc = hdt->A_REG;
-
-                        break;
-                    case JEQ:
-                        if (~hdt->D_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (~hdt->D_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (~hdt->D_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (~hdt->D_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (~hdt->D_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'H':
+                heat_path = optarg;
                 break;
-            case COMP_NOT_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (~hdt->A_REG > 0)
-                            hdt->pc = hdt->A_REG;
-
-                        break;
-                    case JEQ:
-                        if (~hdt->A_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (~hdt->A_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (~hdt->A_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (~hdt->A_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (~hdt->A_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'I':
+                heat_image = optarg;
                 break;
-            case COMP_MINUS_D:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (-hdt->D_REG > 0)
-                            hdt->pc = hdt->A_REG;
-
-                        break;
-                    case JEQ:
-                        if (-hdt->D_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (-hdt->D_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (-hdt->D_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (-hdt->D_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (-hdt->D_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'N':
+                heat_every = (unsigned) strtoul(optarg, NULL, 0);
                 break;
-            case COMP_MINUS_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (-hdt->A_REG > 0)
-                            hdt->pc = hdt->A_REG;
-
-                        break;
-                    case JEQ:
-                        if (-hdt->A_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (-hdt->A_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (-hdt->A_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (-hdt->A_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (-hdt->A_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
+            case 'A':
+                heat_lo = strtol(optarg, &end, 0);
+                heat_hi = *end == '-' ? strtol(end + 1, NULL, 0) : heat_lo;
                 break;
-            case COMP_D_PLUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (++hdt->D_REG > 0)
-                            hdt->pc = hdt->A_REG;
+            default: /* '?' */
+                errprint("Usage: %s [file.hex]\n", argv[0])
+        }
+    }
 
-                        break;
-                    case JEQ:
-                        if (++hdt->D_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (++hdt->D_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (++hdt->D_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (++hdt->D_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (++hdt->D_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_A_PLUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (++hdt->A_REG > 0)
-                            hdt->pc = hdt->A_REG;
+    if (manifest)
+        exit(batch_run(manifest, jobs, flags, symbols, lockstep, prefix, stdout) ? EXIT_FAILURE : EXIT_SUCCESS);
 
-                        break;
-                    case JEQ:
-                        if (++hdt->A_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (++hdt->A_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (++hdt->A_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (++hdt->A_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (++hdt->A_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_MINUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (--hdt->D_REG > 0)
-                            hdt->pc = hdt->A_REG;
+    if (multi) {
+        for (int i = optind; i < argc; ++i) {
+            if (util_fd_isreg(argv[i]) <= 0) {
+                errprint("error: [%s] No such file or directory\n", argv[i])
+                exit(EXIT_FAILURE);
+            }
+        }
+        exit(multi_run(argv + optind, argc - optind, flags, symbols, 256, snapshot) ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
 
-                        break;
-                    case JEQ:
-                        if (--hdt->D_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (--hdt->D_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (--hdt->D_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (--hdt->D_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (--hdt->D_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_A_MINUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (--hdt->A_REG > 0)
-                            hdt->pc = hdt->A_REG;
+    if (argv[optind] == NULL || strlen(argv[optind]) == 0 || util_fd_isreg(argv[optind]) <= 0) {
+        errprint("error: [%s] No such file or directory\n", argv[optind])
+        exit(EXIT_FAILURE);
+    }
 
-                        break;
-                    case JEQ:
-                        if (--hdt->A_REG == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (--hdt->A_REG >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (--hdt->A_REG < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (--hdt->A_REG != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (--hdt->A_REG <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_PLUS_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG + hdt->A_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+    if (!(m = hvm_create(flags | (stats ? HVM_STATS : 0)))) {
+        errprint("error: [%s] %s\n", argv[optind], hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+    if (symbols && (err = hvm_load_symbols(m, symbols))) {
+        errprint("error: [%s] %s\n", symbols, hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    if ((err = hvm_load_file(m, argv[optind]))) {
+        errprint("error: [%s] %s\n", argv[optind], hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    if (restore && (err = checkpoint_restore(m, flags, restore, &instrs))) {
+        errprint("error: [%s] %s\n", restore, err == -1 ? hvm_strerror(HVM_ERR_IO) :
+                                               err == -2 ? "not a checkpoint" :
+                                               err == -3 ? "checkpoint of another ROM" : "checkpoint taken with other -x")
+        exit(EXIT_FAILURE);
+    }
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG + hdt->A_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG + hdt->A_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG + hdt->A_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG + hdt->A_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG + hdt->A_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_MINUS_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG - hdt->A_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+    if (profile) {
+        if (!(entries = calloc(HVM_ROM_SIZE, sizeof(uint64_t)))) {
+            errprint("error: [%s] %s\n", profile, hvm_strerror(HVM_ERR_NOMEM))
+            exit(EXIT_FAILURE);
+        }
+        hvm_set_profile(m, entries);
+    }
+    if ((calls || folded) && !(g = callgraph_attach(m))) {
+        errprint("error: [%s] %s\n", calls ? calls : folded, hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG - hdt->A_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG - hdt->A_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG - hdt->A_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG - hdt->A_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG - hdt->A_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_A_MINUS_D:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->A_REG - hdt->D_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+    if (cover_path || cover_report) {
+        if (!(cover_bits = calloc(HVM_COVER_BYTES, 1))) {
+            errprint("error: [%s] %s\n", cover_path ? cover_path : cover_report, hvm_strerror(HVM_ERR_NOMEM))
+            exit(EXIT_FAILURE);
+        }
+        hvm_set_cover_bits(m, cover_bits);
+    }
+    if (heat_path || heat_image) {
+        if (!(heat = calloc(2 * HVM_RAM_SIZE, sizeof(uint64_t)))) {
+            errprint("error: [%s] %s\n", heat_path ? heat_path : heat_image, hvm_strerror(HVM_ERR_NOMEM))
+            exit(EXIT_FAILURE);
+        }
+        hvm_set_heatmap(m, heat, heat_every, (uint16_t) heat_lo, (uint16_t) heat_hi);
+    }
+    if (trace_path) {
+        if ((trace_fd = open(trace_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+            errprint("error: [%s] %s\n", trace_path, hvm_strerror(HVM_ERR_IO))
+            exit(EXIT_FAILURE);
+        }
+        if (!(trace = hvm_trace_create((size_t) (trace_kb > 0 ? trace_kb : 1) * 1024))) {
+            errprint("error: [%s] %s\n", trace_path, hvm_strerror(HVM_ERR_NOMEM))
+            exit(EXIT_FAILURE);
+        }
+        hvm_set_trace(m, trace);
+        signal(SIGSEGV, trace_signal);
+        signal(SIGBUS, trace_signal);
+        signal(SIGABRT, trace_signal);
+        signal(SIGFPE, trace_signal);
+    }
 
-                        break;
-                    case JEQ:
-                        if ((hdt->A_REG - hdt->D_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->A_REG - hdt->D_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->A_REG - hdt->D_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->A_REG - hdt->D_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->A_REG - hdt->D_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_AND_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG & hdt->A_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+    if (live_name && !(lv = live_open(live_name, m))) {
+        if (errno == EEXIST)
+            errprint("error: [%s] shared memory object exists, in use or left over, see /dev/shm\n", live_name)
+        else
+            errprint("error: [%s] %s\n", live_name, strerror(errno))
+        exit(EXIT_FAILURE);
+    }
+    if (!dump_path) {
+        snprintf(dump_default, sizeof(dump_default), "hvm-%d.dump", (int) getpid());
+        dump_path = dump_default;
+    }
+    signal(SIGUSR1, dump_signal);
+    signal(SIGINT, stop_signal);
+    signal(SIGTERM, stop_signal);
+
+    // degrade to a run without them
+    if (hw && !(hws = hwstats_open()))
+        errprint("warning: --hwstats: perf events unavailable, %s\n", strerror(errno))
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (hws)
+        hwstats_start(hws);
+    // slices end at block entries, where the registers are whole
+    restored = instrs;
+    if (ckpt_every > 0)
+        ckpt_next = instrs + ckpt_every;
+    while (!hvm_halted(m) && !stop_pending) {
+        quantum = slice > 0 ? slice : 1;
+        if (ckpt_next >= 0 && ckpt_next - instrs < quantum)
+            quantum = ckpt_next - instrs > 0 ? ckpt_next - instrs : 1;
+        instrs += hvm_run_slice(m, quantum);
+        if (lv)
+            live_update(lv, m, instrs);
+        if (ckpt_next >= 0 && instrs >= ckpt_next && !hvm_halted(m)) {
+            if (checkpoint_write(m, flags, instrs, ckpt_path))
+                errprint("error: [%s] unable to write checkpoint\n", ckpt_path)
+            ckpt_next = instrs + ckpt_every;
+        }
+        if (dump_pending) {
+            dump_pending = 0;
+            dump_write(m, instrs, dump_ram, "SIGUSR1", dump_path);
+        }
+    }
+    if (hws)
+        hwstats_stop(hws);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (trace) {
+        trace_write();
+        hvm_set_trace(m, NULL);
+        hvm_trace_destroy(trace);
+        close(trace_fd);
+    }
+    if (stop_pending)
+        dump_write(m, instrs, dump_ram, stop_pending == SIGINT ? "SIGINT" : "SIGTERM", dump_path);
+    // preempted, pick up from here
+    if (stop_pending && ckpt_every > 0 && checkpoint_write(m, flags, instrs, ckpt_path))
+        errprint("error: [%s] unable to write checkpoint\n", ckpt_path)
+    if (!(snap = snap_path ? fopen(snap_path, snap_format < 0 ? "w" : "wb") : stdout)) {
+        errprint("error: [%s] %s\n", snap_path, hvm_strerror(HVM_ERR_IO))
+    } else if (snap_format < 0) {
+        snapshot_write(m, snap);
+    } else if (dump_snapshot(m, (enum dump_format) snap_format, snap_ranges, snap_n, snap)) {
+        errprint("error: [%s] unable to write snapshot\n", snap_path ? snap_path : "stdout")
+    }
+    if (snap && snap != stdout)
+        fclose(snap);
+    if (stats)
+        stats_report(m, (double) (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    if (hws) {
+        hwstats_report(hws, instrs - restored, stderr);
+        hwstats_close(hws);
+    }
+    if (profile && profile_write(m, flags, entries, profile))
+        errprint("error: [%s] unable to write profile\n", profile)
+    free(entries);
+    if (calls && callgraph_write_table(g, calls))
+        errprint("error: [%s] unable to write call graph\n", calls)
+    if (folded && callgraph_write_folded(g, folded))
+        errprint("error: [%s] unable to write call graph\n", folded)
+    callgraph_destroy(g);
+    if (cover_path && (err = coverage_merge(m, cover_bits, cover_path)))
+        errprint("error: [%s] %s\n", cover_path, err == -2 ? "coverage of another ROM" : "unable to merge coverage")
+    if (cover_report && coverage_report(m, flags, cover_bits, cover_report))
+        errprint("error: [%s] unable to write coverage report\n", cover_report)
+    free(cover_bits);
+    if (heat_path && heatmap_write(heat, heat_every, heat_path))
+        errprint("error: [%s] unable to write heatmap\n", heat_path)
+    if (heat_image && heatmap_image(heat, heat_image))
+        errprint("error: [%s] unable to write heatmap\n", heat_image)
+    free(heat);
+    hvm_destroy(m);
+    live_close(lv);
+    if (stop_pending)
+        exit(128 + stop_pending);
+}
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG & hdt->A_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG & hdt->A_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG & hdt->A_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG & hdt->A_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG & hdt->A_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_OR_A:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG | hdt->A_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+static void snapshot(const hvm_machine *m) {
+    snapshot_write(m, stdout);
+}
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG | hdt->A_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG | hdt->A_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG | hdt->A_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG | hdt->A_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG | hdt->A_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (RAM[hdt->A_REG] > 0)
-                            hdt->pc = hdt->A_REG;
+static void snapshot_write(const hvm_machine *m, FILE *fp) {
+    char *msg = " _   ___      ____  __   \n"
+                "| | | |\\ \\   / |  \\/  |  \n"
+                "| |_| | \\ \\ / /| |\\/| |  \n"
+                "|  _  |  \\ V / | |  | |  \n"
+                "|_| |_|   \\_/  |_|  |_|  \n"
+                "                          \n"
+                "Memory Snapshot \n"
+                "****************************************\n"
+                "*           *            *    CPU      *\n"
+                "*           *            ***************\n"
+                "*   ROM     *   RAM      |  A REG [%d]  \n"
+                "*           *            |--------------\n"
+                "*           *            |  D REG [%d]  \n"
+                "*           *            |--------------\n"
+                "*           *            |  PC [%d]     \n";
 
-                        break;
-                    case JEQ:
-                        if (RAM[hdt->A_REG] == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (RAM[hdt->A_REG] >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (RAM[hdt->A_REG] < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (RAM[hdt->A_REG] != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (RAM[hdt->A_REG] <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_NOT_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (~RAM[hdt->A_REG] > 0)
-                            hdt->pc = hdt->A_REG;
+    char *memories = "_________________________\n"
+                "|  %x             %d     \n";
+    fprintf(fp, msg, hvm_get_reg(m, HVM_REG_A), hvm_get_reg(m, HVM_REG_D), hvm_get_reg(m, HVM_REG_PC));
+    for (int i = 0; i < hvm_rom_len(m); ++i) {
+        fprintf(fp, memories, hvm_rom(m, i), hvm_read(m, i));
+    }
 
-                        break;
-                    case JEQ:
-                        if (~RAM[hdt->A_REG] == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (~RAM[hdt->A_REG] >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (~RAM[hdt->A_REG] < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (~RAM[hdt->A_REG] != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (~RAM[hdt->A_REG] <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_MINUS_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (-RAM[hdt->A_REG] > 0)
-                            hdt->pc = hdt->A_REG;
+}
 
-                        break;
-                    case JEQ:
-                        if (-RAM[hdt->A_REG] == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (-RAM[hdt->A_REG] >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (-RAM[hdt->A_REG] < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (-RAM[hdt->A_REG] != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (-RAM[hdt->A_REG] <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_M_PLUS_1:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if (++RAM[hdt->A_REG] > 0)
-                            hdt->pc = hdt->A_REG;
+static void stats_report(const hvm_machine *m, double sec) {
+    struct hvm_stats st;
+    double total;
+
+    hvm_get_stats(m, &st);
+    total = st.instrs ? (double) st.instrs : 1.0;
+    fprintf(stderr, "instrs           %lu\n", st.instrs);
+    fprintf(stderr, "  A instrs       %lu (%.1f%%)\n", st.a_instrs, 100.0 * st.a_instrs / total);
+    fprintf(stderr, "  C instrs       %lu (%.1f%%)\n", st.c_instrs, 100.0 * st.c_instrs / total);
+    fprintf(stderr, "jumps taken      %lu\n", st.jumps_taken);
+    fprintf(stderr, "jumps not taken  %lu\n", st.jumps_not_taken);
+    fprintf(stderr, "RAM reads        %lu\n", st.ram_reads);
+    fprintf(stderr, "RAM writes       %lu\n", st.ram_writes);
+    fprintf(stderr, "wall time        %.6f s\n", sec);
+    fprintf(stderr, "MIPS             %.2f\n", sec > 0 ? st.instrs / sec / 1e6 : 0.0);
+}
 
-                        break;
-                    case JEQ:
-                        if (++RAM[hdt->A_REG] == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if (++RAM[hdt->A_REG] >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if (++RAM[hdt->A_REG] < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if (++RAM[hdt->A_REG] != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if (++RAM[hdt->A_REG] <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_PLUS_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) > 0)
-                            hdt->pc = hdt->A_REG;
+/* Async-signal-safe, a dump from a handler replaces one written before */
+static void trace_write(void) {
+    if (lseek(trace_fd, 0, SEEK_SET) || ftruncate(trace_fd, 0) || hvm_trace_dump(trace, trace_fd))
+        write(STDERR_FILENO, "error: unable to write trace\n", 29);
+}
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG + RAM[hdt->A_REG]) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_MINUS_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) > 0)
-                            hdt->pc = hdt->A_REG;
+static void trace_signal(int sig) {
+    trace_write();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG - RAM[hdt->A_REG]) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_M_MINUS_D:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) > 0)
-                            hdt->pc = hdt->A_REG;
+static void dump_signal(int sig) {
+    (void) sig;
+    dump_pending = 1;
+}
 
-                        break;
-                    case JEQ:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((RAM[hdt->A_REG] - hdt->D_REG) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_AND_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) > 0)
-                            hdt->pc = hdt->A_REG;
+/* A second one while the run winds down kills */
+static void stop_signal(int sig) {
+    stop_pending = sig;
+    signal(sig, SIG_DFL);
+}
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG & RAM[hdt->A_REG]) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
-                }
-                break;
-            case COMP_D_OR_M:
-                switch (hdt->jmp) {
-                    case JGT:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) > 0)
-                            hdt->pc = hdt->A_REG;
+static void dump_write(const hvm_machine *m, long instrs, int ram, const char *why, const char *path) {
+    FILE *fp = fopen(path, "a");
 
-                        break;
-                    case JEQ:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) == 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JGE:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) >= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLT:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) < 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JNE:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) != 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JLE:
-                        if ((hdt->D_REG | RAM[hdt->A_REG]) <= 0)
-                            hdt->pc = hdt->A_REG;
-                        break;
-                    case JMP:
-                        hdt->pc = hdt->A_REG;
-                        break;
-                    default:
-                        break;
+    if (!fp || dump_state(m, instrs, ram, why, fp))
+        errprint("error: [%s] unable to write dump\n", path)
+    if (fp)
+        fclose(fp);
+}
 
-                }
-                break;
-            default:
-                running = 0;
-                break;
-        }
+static int util_fd_isreg(const char *filename) {
+    struct stat st;
 
-    }
+    if (stat(filename, &st))
+        return -1;
 
+    return S_ISREG(st.st_mode);
 }
-
@@ -0,0 +1,344 @@
+/*
+ * hvm.h
+ *
+ * libhvm, embeddable Hack virtual machine.
+ *
+ * Each hvm_machine owns its RAM and registers, any number of them can live
+ * in one process. The ROM and the tables decoded from it are held by a
+ * reference counted hvm_program which machines running the same code share.
+ * RAM pages are allocated, or copied from the checkpoint the machine was
+ * forked from, on first write. A machine that can not get one halts.
+ */
+
+#ifndef HVM_HVM_H
+#define HVM_HVM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* 32K words of instruction memory */
+#define HVM_ROM_SIZE 32768
+
+/* 32K words of data memory, screen and keyboard included */
+#define HVM_RAM_SIZE 32768
+
+/* RAM is allocated in pages of this many words on first write */
+#define HVM_PAGE_SIZE 256
+
+/* Memory mapped I/O */
+#define HVM_SCREEN 0x4000
+#define HVM_SCREEN_SIZE 0x2000
+#define HVM_KBD 0x6000
+
+typedef struct hvm_machine hvm_machine;
+typedef struct hvm_program hvm_program;
+typedef struct hvm_checkpoint hvm_checkpoint;
+typedef struct hvm_trace hvm_trace;
+
+enum hvm_status {
+    HVM_OK          = 0,
+    HVM_ERR_IO      = -1,   // file can not be opened or read
+    HVM_ERR_FORMAT  = -2,   // image shorter than its header
+    HVM_ERR_SIZE    = -3,   // program does not fit into ROM
+    HVM_ERR_NOMEM   = -4,
+    HVM_ERR_NOSYMS  = -5,   // OS emulation asked for without a symbol map
+};
+
+enum hvm_flags {
+    HVM_NO_FUSE     = 1u << 0u,     // step through VM translator sequences instead of fusing them
+    HVM_EMULATE_OS  = 1u << 1u,     // run Jack OS Math and Memory routines natively
+    HVM_EXTENDED    = 1u << 2u,     // extended ALU, 101 prefixed C instrs
+    HVM_STATS       = 1u << 3u,     // count instrs by class, see hvm_get_stats()
+};
+
+enum hvm_reg {
+    HVM_REG_A,
+    HVM_REG_D,
+    HVM_REG_PC
+};
+
+/*
+ * Program with a reference count of 1. HVM_NO_FUSE and HVM_EMULATE_OS are
+ * taken from the program's flags, HVM_EXTENDED from the machine's. Load
+ * symbols and then the image before the program is shared, it is read
+ * only from then on and may be attached by machines on any thread.
+ */
+hvm_program *hvm_program_create(unsigned flags);
+hvm_program *hvm_program_retain(hvm_program *prog);
+void hvm_program_release(hvm_program *prog);
+
+int hvm_program_load_buffer(hvm_program *prog, const void *buf, size_t len);
+int hvm_program_load_file(hvm_program *prog, const char *path);
+int hvm_program_load_symbols(hvm_program *prog, const char *path);
+
+/* Create a machine with the given hvm_flags, NULL if out of memory */
+hvm_machine *hvm_create(unsigned flags);
+void hvm_destroy(hvm_machine *m);
+
+/* Run prog on m, holding a reference to it. The machine is reset. */
+void hvm_attach(hvm_machine *m, hvm_program *prog);
+
+/*
+ * Load a .hex image, from a buffer or a file, into a program of the
+ * machine's own. The machine is reset. Symbols used for OS emulation
+ * must be loaded before the program.
+ */
+int hvm_load_buffer(hvm_machine *m, const void *buf, size_t len);
+int hvm_load_file(hvm_machine *m, const char *path);
+
+/*
+ * Symbol map, one 'name address' pair per line, optionally followed by
+ * 'rom' for a label or 'ram' for a variable. Without it the predefined
+ * symbols and Jack statics ('Class.N') are taken for RAM, other names for
+ * ROM labels.
+ */
+int hvm_load_symbols(hvm_machine *m, const char *path);
+
+/* First name the symbol map gives addr, NULL if none */
+const char *hvm_symbol(const hvm_machine *m, uint16_t addr);
+
+/* First ROM label the symbol map gives addr, NULL if none */
+const char *hvm_label(const hvm_machine *m, uint16_t addr);
+
+/* Clear RAM and registers, keep the loaded program. RAM pages are freed. */
+void hvm_reset(hvm_machine *m);
+
+/*
+ * Run until the machine halts or max_steps instrs were executed,
+ * max_steps < 0 runs until halt. Returns the number of instrs executed.
+ */
+long hvm_run(hvm_machine *m, long max_steps);
+
+/*
+ * Run at least quantum instrs, unless the machine halts, then on to the
+ * next jump that lands, so the machine stops at the entry of a block.
+ */
+long hvm_run_slice(hvm_machine *m, long quantum);
+
+/*
+ * Keyboard reads that found no key pressed since the last reset. Fused
+ * ops count '@KBD D=M', push of KBD and the Jack OS Keyboard.keyPressed()
+ * through Memory.peek(); stepped ROM, with HVM_NO_FUSE or not, counts
+ * every load of the KBD address into A.
+ */
+unsigned long hvm_kbd_idle(const hvm_machine *m);
+
+/*
+ * Instrs executed by hvm_run() and hvm_run_slice() since reset or fork,
+ * kept on machines created with HVM_STATS. Jumps are C instrs with jump
+ * bits, RAM reads and writes those with M as operand or destination. Fused
+ * ops count the instrs they stand for, by the ROM words they replace.
+ */
+struct hvm_stats {
+    unsigned long instrs;
+    unsigned long a_instrs;
+    unsigned long c_instrs;
+    unsigned long jumps_taken;
+    unsigned long jumps_not_taken;
+    unsigned long ram_reads;
+    unsigned long ram_writes;
+};
+
+void hvm_get_stats(const hvm_machine *m, struct hvm_stats *stats);
+
+/*
+ * Called at the end of each block with the address it was entered at, the
+ * address after its last instr and the instrs it ran. Control went on to
+ * the machine's PC, which equals next unless a jump was taken. The block
+ * a machine halts in ends there too. Blocks are those of hvm_set_profile(),
+ * the current PC is taken as an entry when the hook is set.
+ */
+typedef void (*hvm_block_hook)(void *ctx, hvm_machine *m, uint16_t entry, uint16_t next, unsigned long instrs);
+
+void hvm_set_block_hook(hvm_machine *m, hvm_block_hook hook, void *ctx);
+
+/*
+ * Ring buffer, about bytes in size, of the last runs of straight line code:
+ * one is recorded each time control lands elsewhere than the next word, and
+ * when the machine halts, as its start and length in 2 to 6 bytes. The
+ * instrs follow from the ROM, jumps inside a run fell through and the one
+ * ending it was taken. Fused ops are runs of the words they replace.
+ */
+hvm_trace *hvm_trace_create(size_t bytes);
+void hvm_trace_destroy(hvm_trace *t);
+
+/* Record m's runs into t, starting at the current PC. NULL stops recording. */
+void hvm_set_trace(hvm_machine *m, hvm_trace *t);
+
+/*
+ * Write the ring to fd, async-signal-safe. The layout is the magic 'HVMT',
+ * then chunk size, chunk count and the chunk written last as 32 bit little
+ * endian words, then the chunks. A chunk starts with the 16 bit little
+ * endian count of its bytes in use, this count included, followed by a
+ * record per run: its start as a zigzag varint delta from the end of the
+ * chunk's previous run (from 0 for the first) and its length in words as a
+ * varint. Returns 0, -1 if the write failed.
+ */
+int hvm_trace_dump(const hvm_trace *t, int fd);
+
+/*
+ * Count block entries into counts, HVM_ROM_SIZE of them indexed by the ROM
+ * address a block was entered at, one increment per block. A block runs
+ * from its entry through the next jump instr; fused ops other than if-goto
+ * and compare end one only if they land elsewhere. The current PC counts as an entry
+ * when set, and after reset or fork. NULL turns counting off.
+ */
+void hvm_set_profile(hvm_machine *m, uint64_t *counts);
+
+/*
+ * Count edges between blocks into map, AFL style: every jump instr, taken
+ * or not, ends a block and bumps the counter for the (previous block, next
+ * block) pair. Only the largest power of 2 not above size, at most 64K,
+ * is used. NULL turns counting off. hvm_step() and lockstep runs do not
+ * count.
+ */
+void hvm_set_coverage(hvm_machine *m, uint8_t *map, size_t size);
+
+/*
+ * Coverage bitmap, a bit per ROM address in each of three tables, at these
+ * byte offsets: blocks entered, jump instrs taken and jump instrs not taken.
+ * Unconditional jumps are always taken. Bitmaps of runs of the same ROM
+ * merge by OR.
+ */
+#define HVM_COVER_ENTRY 0
+#define HVM_COVER_TAKEN (HVM_ROM_SIZE / 8)
+#define HVM_COVER_NOT_TAKEN (2 * HVM_ROM_SIZE / 8)
+#define HVM_COVER_BYTES (3 * HVM_ROM_SIZE / 8)
+
+/*
+ * Set bits in bits, HVM_COVER_BYTES of them, as blocks end. Blocks are
+ * those of hvm_set_profile(), the current PC is taken as an entry when set
+ * and after reset or fork. NULL turns it off. hvm_step() and lockstep runs
+ * do not mark.
+ */
+void hvm_set_cover_bits(hvm_machine *m, uint8_t *bits);
+
+/*
+ * Sample RAM accesses into counts, 2 * HVM_RAM_SIZE of them: reads of each
+ * address, then writes. One in every accesses to addresses lo..hi is
+ * counted, every 0 or 1 counts all of them. While sampling, fused ops and
+ * emulated OS routines run as the instrs they replace, whose M operands
+ * and destinations are the accesses. NULL turns it off, at no cost to
+ * runs. hvm_step() and lockstep runs do not sample.
+ */
+void hvm_set_heatmap(hvm_machine *m, uint64_t *counts, unsigned every, uint16_t lo, uint16_t hi);
+
+/* Machines per lockstep group, one 256 bit vector of 16 bit registers */
+#define HVM_LANES 16
+
+/*
+ * Run n machines on one program in lockstep, HVM_LANES at a time, each
+ * until it halts or executed max_steps instrs. Machines attached to a
+ * different program or with different flags than ms[0] run on their own.
+ * Returns the total number of instrs executed, counts (if not NULL)
+ * receives the number for each machine.
+ */
+long hvm_run_lockstep(hvm_machine **ms, int n, long max_steps, long *counts);
+
+/* Execute a single instr, returns 0 if the machine is halted */
+int hvm_step(hvm_machine *m);
+
+int hvm_halted(const hvm_machine *m);
+
+int hvm_get_reg(const hvm_machine *m, enum hvm_reg reg);
+void hvm_set_reg(hvm_machine *m, enum hvm_reg reg, int value);
+
+int16_t hvm_read(const hvm_machine *m, uint16_t addr);
+void hvm_write(hvm_machine *m, uint16_t addr, int16_t value);
+
+/*
+ * Number of RAM pages the machine holds of its own, the pages written
+ * since reset or fork. Other pages read 0 or the checkpoint's words.
+ */
+int hvm_ram_resident(const hvm_machine *m);
+
+/*
+ * Digest of RAM words lo through hi, for telling whether they changed:
+ * differing digests mean differing words. Pages never written cost
+ * nothing.
+ */
+uint64_t hvm_ram_digest(const hvm_machine *m, uint16_t lo, uint16_t hi);
+
+/*
+ * Capture the machine's registers and RAM, with a reference count of 1.
+ * The machine's pages move into the checkpoint, so the machine, like every
+ * one forked from it later, copies a page on its first write to it. A
+ * checkpoint is read only and may be forked from on any thread.
+ */
+hvm_checkpoint *hvm_checkpoint_create(hvm_machine *m);
+hvm_checkpoint *hvm_checkpoint_retain(hvm_checkpoint *cp);
+void hvm_checkpoint_release(hvm_checkpoint *cp);
+
+/* Continue from cp on m, attached to cp's program with its flags. Costs the pages m had written. */
+void hvm_fork(hvm_machine *m, hvm_checkpoint *cp);
+
+/*
+ * Back all of RAM with one block of HVM_RAM_SIZE words and return it, NULL
+ * if out of memory. The block stays in place, and in use, until the machine
+ * is destroyed: reset clears it and fork copies into it.
+ */
+int16_t *hvm_ram_pin(hvm_machine *m);
+
+/*
+ * Pin RAM, as above, into ram, a block of HVM_RAM_SIZE words the caller
+ * owns, shared memory say. The machine's words are moved in, RAM pinned
+ * before is let go. ram must outlive the machine, which never frees it.
+ */
+void hvm_ram_map(hvm_machine *m, int16_t *ram);
+
+/*
+ * As hvm_ram_map(), but ram's words are taken as RAM and the machine's
+ * dropped: RAM saved to a file comes back through a private mapping of
+ * it, read in page by page as the program touches it.
+ */
+void hvm_ram_adopt(hvm_machine *m, int16_t *ram);
+
+/* Loaded program, ROM words past hvm_rom_len() are zero */
+uint16_t hvm_rom(const hvm_machine *m, uint16_t addr);
+int hvm_rom_len(const hvm_machine *m);
+
+/* FNV-1a hash of the loaded words, to tell state saved for other ROMs */
+uint32_t hvm_rom_hash(const hvm_machine *m);
+
+/* Program the machine runs, not retained. Its ROM is HVM_ROM_SIZE words. */
+hvm_program *hvm_get_program(const hvm_machine *m);
+const uint16_t *hvm_program_rom(const hvm_program *prog);
+
+const char *hvm_strerror(int status);
+
+/*
+ * Cooperative scheduler, many machines on one thread. Machines take turns
+ * of about quantum instrs, ending at a block entry, in proportion to their
+ * weight: a machine of weight 2 gets twice the instrs of one of weight 1.
+ * A machine that polls an empty keyboard through two turns in a row and
+ * writes no RAM outside the registers and the stack meanwhile is parked
+ * until hvm_sched_key() hands it a key, halted machines are parked for
+ * good. Parked machines cost nothing per turn.
+ */
+typedef struct hvm_sched hvm_sched;
+
+enum hvm_sched_state {
+    HVM_SCHED_RUNNABLE,
+    HVM_SCHED_KBD_WAIT,
+    HVM_SCHED_HALTED
+};
+
+hvm_sched *hvm_sched_create(long quantum);
+
+/* Machines stay with the caller, they are not destroyed */
+void hvm_sched_destroy(hvm_sched *s);
+
+/* Returns the machine's id, a negative hvm_status on failure */
+int hvm_sched_add(hvm_sched *s, hvm_machine *m, int weight);
+void hvm_sched_set_weight(hvm_sched *s, int id, int weight);
+
+/* Run turns until max_steps instrs (< 0 no limit) or no machine is runnable, returns instrs executed */
+long hvm_sched_run(hvm_sched *s, long max_steps);
+
+/* Put key into the machine's keyboard register, waking it if it waits for one */
+void hvm_sched_key(hvm_sched *s, int id, int16_t key);
+
+enum hvm_sched_state hvm_sched_state(const hvm_sched *s, int id);
+int hvm_sched_runnable(const hvm_sched *s);
+
+#endif //HVM_HVM_H
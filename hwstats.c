@@ -0,0 +1,129 @@
+/*
+ * hwstats.c
+ *
+ * Host performance counters around the interpreter, through
+ * perf_event_open(2). Each counter is opened on its own rather than as a
+ * group, so a CPU or VM lacking one still reports the rest.
+ */
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "hwstats.h"
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u))
+
+enum {
+    HW_CYCLES,
+    HW_INSTRS,
+    HW_BRANCH_MISSES,
+    HW_L1I_MISSES,
+    HW_L1D_MISSES,
+    HW_COUNTERS
+};
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} counters[HW_COUNTERS] = {
+        {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"L1i misses",    PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1I)},
+        {"L1d misses",    PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+};
+
+struct hwstats {
+    int fd[HW_COUNTERS];
+    double count[HW_COUNTERS];  // -1 if not counted
+};
+
+hwstats *hwstats_open(void) {
+    hwstats *h = malloc(sizeof(hwstats));
+    struct perf_event_attr attr;
+    int opened = 0, err = ENOENT;
+
+    if (!h)
+        return NULL;
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counters[i].type;
+        attr.config = counters[i].config;
+        attr.disabled = 1;
+        // user space only, allowed at perf_event_paranoid 2
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        h->fd[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        h->count[i] = -1;
+        if (h->fd[i] >= 0)
+            ++opened;
+        else
+            err = errno;
+    }
+    if (!opened) {
+        free(h);
+        errno = err;
+        return NULL;
+    }
+    return h;
+}
+
+void hwstats_close(hwstats *h) {
+    if (!h)
+        return;
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        if (h->fd[i] >= 0)
+            close(h->fd[i]);
+    }
+    free(h);
+}
+
+void hwstats_start(hwstats *h) {
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        if (h->fd[i] >= 0) {
+            ioctl(h->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(h->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void hwstats_stop(hwstats *h) {
+    // value, time enabled, time running
+    uint64_t v[3];
+
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        if (h->fd[i] >= 0)
+            ioctl(h->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        if (h->fd[i] < 0 || read(h->fd[i], v, sizeof(v)) != sizeof(v) || !v[2])
+            continue;
+        h->count[i] = (double) v[0] * ((double) v[1] / (double) v[2]);
+    }
+}
+
+void hwstats_report(const hwstats *h, long instrs, FILE *fp) {
+    const double *c = h->count;
+    double per = instrs > 0 ? (double) instrs : 1.0;
+
+    for (int i = 0; i < HW_COUNTERS; ++i) {
+        if (c[i] < 0)
+            fprintf(fp, "host %-14s not supported\n", counters[i].name);
+        else
+            fprintf(fp, "host %-14s %.0f (%.3f per instr)\n", counters[i].name, c[i], c[i] / per);
+    }
+    if (c[HW_CYCLES] > 0 && c[HW_INSTRS] >= 0)
+        fprintf(fp, "host IPC           %.2f\n", c[HW_INSTRS] / c[HW_CYCLES]);
+    if (c[HW_INSTRS] > 0 && c[HW_BRANCH_MISSES] >= 0)
+        fprintf(fp, "branch-misses      %.2f per 1000 host instrs\n", 1000 * c[HW_BRANCH_MISSES] / c[HW_INSTRS]);
+}
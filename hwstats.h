@@ -0,0 +1,32 @@
+/*
+ * hwstats.h
+ */
+
+#ifndef HVM_HWSTATS_H
+#define HVM_HWSTATS_H
+
+#include <stdio.h>
+
+typedef struct hwstats hwstats;
+
+/*
+ * Host hardware counters of the calling thread, user space only: cycles,
+ * instructions, branch misses, L1i and L1d read misses, opened stopped.
+ * Counters the kernel or CPU refuse are left out, NULL if none could be
+ * opened, with the reason in errno.
+ */
+hwstats *hwstats_open(void);
+void hwstats_close(hwstats *h);
+
+/* Count between start and stop, around the run loop only */
+void hwstats_start(hwstats *h);
+void hwstats_stop(hwstats *h);
+
+/*
+ * Print the counts to fp, scaled up where the kernel multiplexed counters,
+ * with their rate per emulated instr out of instrs, and the IPC and miss
+ * rates of the host.
+ */
+void hwstats_report(const hwstats *h, long instrs, FILE *fp);
+
+#endif //HVM_HWSTATS_H
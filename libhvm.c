@@ -0,0 +1,2278 @@
+/*
+ * libhvm.c
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <memory.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "hvm.h"
+#include "hopcodes.h"
+
+/* End of signature */
+#define EOS 0xFFFF 
+
+/* payload offset */
+#define P_OFF 0x8 
+
+#define ROM_SIZE HVM_ROM_SIZE
+#define RAM_SIZE HVM_RAM_SIZE
+
+/* RAM pages, allocated on first write */
+#define PAGE_SIZE HVM_PAGE_SIZE
+#define PAGE_BITS 8u
+#define RAM_PAGES (RAM_SIZE / PAGE_SIZE)
+
+#define EmitComp(n) ((n & 0xFFC0u) >> 6u)
+#define EmitDest(n) ((n & 0x38u) >> 3u)
+#define EmitJmp(n) (n & 0x07u)
+
+/* Assemble a C instr from its comp,dest,jmp parts */
+#define C_INSTR(comp, dest, jmp) ((u16) (((comp) << 6u) | ((dest) << 3u) | (jmp)))
+
+/* Wrap addresses into memory bounds */
+#define M_ADDR(n) ((u16) (n) & (RAM_SIZE - 1u))
+#define PC_ADDR(n) ((u16) (n) & (ROM_SIZE - 1u))
+
+/* VM translator pointers and temp registers in RAM */
+#define R_SP   0x0
+#define R_LCL  0x1
+#define R_ARG  0x2
+#define R_THIS 0x3
+#define R_THAT 0x4
+
+typedef uint16_t u16;
+typedef uint8_t u8;
+typedef uint32_t u32;
+
+typedef struct {
+    u16 comp:10;
+    u8 dest:3;
+    u8 jmp:3;
+    int16_t A_REG:16;
+    int16_t D_REG:16;
+    int state;
+    int pc;
+} HVMData;
+
+enum hvm_state {
+    hvm_fetch,
+    hvm_decode,
+    hvm_execute
+};
+
+/* Fused ops, canonical instr sequences run as one native op */
+enum hvm_xop {
+    xop_none,
+    xop_call,
+    xop_return,
+    xop_push_const,
+    xop_push_seg,
+    xop_push_mem,
+    xop_pop_seg,
+    xop_pop_mem,
+    xop_binary,
+    xop_unary,
+    xop_compare,
+    xop_if_goto,
+    xop_kbd,
+    xop_hle
+};
+
+/* Jack OS routines with a native implementation */
+enum hvm_hle {
+    hle_multiply,
+    hle_divide,
+    hle_sqrt,
+    hle_alloc,
+    hle_dealloc,
+    hle_count
+};
+
+typedef struct {
+    char name[128];
+    u16 addr;
+    u8 ram;     // a RAM variable, not a ROM label
+} HVMSym;
+
+typedef struct {
+    u8 kind;
+    u8 len;     // number of ROM words the op stands for
+    u8 form;    // which push sequence the translator used, or the OS routine
+    u16 arg[3];
+} HVMXop;
+
+/* Loaded program and everything decoded from it, read only once shared */
+struct hvm_program {
+    atomic_int refs;
+    unsigned flags;
+
+    /* ROM ends in an EOS sentinel so pc can never run off it */
+    u16 rom[ROM_SIZE + 1];
+
+    /* Number of words loaded into ROM */
+    int rom_len;
+
+    /* Fused ops, xidx maps ROM address to its entry in xops, 0 if none */
+    u16 xidx[ROM_SIZE + 1];
+    HVMXop xops[ROM_SIZE / 2];
+    int xop_count;
+
+    /* Free list head of the emulated Memory routines */
+    u16 hle_heap;
+
+    /* Symbol map, label and variable addresses by name */
+    HVMSym *syms;
+    int sym_count;
+    int sym_cap;
+};
+
+struct hvm_machine {
+    HVMData hdt;
+
+    /* Current state of machine */
+    int running;
+    unsigned flags;
+
+    /*
+     * RAM, pages never written to map zero_page or the checkpoint's page the
+     * machine was forked from. own holds the pages of its own, NULL until
+     * the first write since reset or fork copies the page.
+     */
+    int16_t *page[RAM_PAGES];
+    int16_t *own[RAM_PAGES];
+    int resident;
+    hvm_checkpoint *base;
+
+    /* Contiguous RAM once pinned, every page maps and owns its slice of it */
+    int16_t *ram;
+    int ram_foreign;    // the caller's, see hvm_ram_map()
+
+    /* Takes writes once a page can not be allocated */
+    int16_t sink;
+
+    /* Keyboard reads that found no key, seen by fused ops only */
+    unsigned long kbd_idle;
+
+    /* Edge counters, cover_prev is the hashed entry of the block left last */
+    u8 *cover;
+    u16 cover_mask;
+    u16 cover_prev;
+
+    /* Block entries and jump outcomes seen, see HVM_COVER_BYTES */
+    u8 *cover_bits;
+
+    /* Counts by instr class, kept with HVM_STATS */
+    struct hvm_stats stats;
+
+    /* Executions of each block, by the ROM address it was entered at */
+    uint64_t *prof;
+
+    /* Called at the end of every block, with the block's entry and instrs */
+    hvm_block_hook hook;
+    void *hook_ctx;
+    u16 block_entry;
+    unsigned long block_steps;
+
+    /* Sampled RAM reads and writes, one in heat_every in heat_lo..heat_hi */
+    uint64_t *heat;
+    unsigned heat_every;
+    unsigned heat_left;
+    u16 heat_lo;
+    u16 heat_hi;
+
+    /* Ring of the last runs of straight line code */
+    hvm_trace *trace;
+    u16 trace_entry;
+
+    /* Program being run, never NULL */
+    hvm_program *prog;
+};
+
+/* Machine state shared by the machines forked from it, read only */
+struct hvm_checkpoint {
+    atomic_int refs;
+    hvm_checkpoint *parent;     // owns the pages not in own
+    hvm_program *prog;
+    unsigned flags;
+    HVMData hdt;
+    int running;
+    unsigned long kbd_idle;
+    int16_t *page[RAM_PAGES];
+    int16_t *own[RAM_PAGES];
+};
+
+/* Backs every page not written yet, read only */
+static const int16_t zero_page[PAGE_SIZE];
+
+static int16_t *page_alloc(hvm_machine *, u16) __attribute__((cold, noinline));
+
+static inline int16_t ram_read(const hvm_machine *m, int a) {
+    u16 w = M_ADDR(a);
+
+    return m->page[w >> PAGE_BITS][w & (PAGE_SIZE - 1u)];
+}
+
+/* Word at a for writing, its page is allocated on the first write */
+static inline int16_t *ram_ref(hvm_machine *m, int a) {
+    u16 w = M_ADDR(a);
+    int16_t *page = m->own[w >> PAGE_BITS];
+
+    if (__builtin_expect(!page, 0))
+        return page_alloc(m, w);
+    return &page[w & (PAGE_SIZE - 1u)];
+}
+
+/* Set the bit for ROM address addr in the coverage table at byte offset at */
+static inline void cover_bit(u8 *bits, int at, int addr) {
+    bits[at + (addr >> 3u)] |= (u8) (1u << (addr & 7u));
+}
+
+/* VM State: Fetch, Decode, Execute */
+static u16 fetch(hvm_machine *);
+static void decode(u16, hvm_machine *);
+static void execute(hvm_machine *);
+static int jump_taken(u8, int16_t);
+static int step(hvm_machine *);
+
+/* Fused ops: load time scan and native execution */
+static void xop_scan(hvm_program *);
+static int xop_exec(hvm_machine *, const HVMXop **);
+
+/* Jack OS high level emulation */
+static int hle_install(hvm_program *);
+static int hle_exec(hvm_machine *, const HVMXop *);
+
+/* Symbol map */
+static int sym_find(const hvm_program *, const char *, u16 *);
+
+
+hvm_program *hvm_program_create(unsigned flags) {
+    hvm_program *prog = calloc(1, sizeof(hvm_program));
+
+    if (!prog)
+        return NULL;
+    atomic_init(&prog->refs, 1);
+    prog->flags = flags;
+    prog->rom[0] = EOS;
+    prog->xop_count = 1;
+    return prog;
+}
+
+hvm_program *hvm_program_retain(hvm_program *prog) {
+    atomic_fetch_add_explicit(&prog->refs, 1, memory_order_relaxed);
+    return prog;
+}
+
+void hvm_program_release(hvm_program *prog) {
+    if (!prog || atomic_fetch_sub_explicit(&prog->refs, 1, memory_order_acq_rel) != 1)
+        return;
+    free(prog->syms);
+    free(prog);
+}
+
+hvm_machine *hvm_create(unsigned flags) {
+    hvm_machine *m = calloc(1, sizeof(hvm_machine));
+
+    if (!m)
+        return NULL;
+    if (!(m->prog = hvm_program_create(flags))) {
+        free(m);
+        return NULL;
+    }
+    m->flags = flags;
+    for (int i = 0; i < RAM_PAGES; ++i)
+        m->page[i] = (int16_t *) zero_page;
+    return m;
+}
+
+/* Free the machine's own pages and map every page to zero_page, pinned RAM is cleared instead */
+static void page_release(hvm_machine *m) {
+    if (m->ram)
+        memset(m->ram, 0, RAM_SIZE * sizeof(int16_t));
+    for (int i = 0; !m->ram && (m->resident || m->base) && i < RAM_PAGES; ++i) {
+        if (m->own[i]) {
+            free(m->own[i]);
+            m->own[i] = NULL;
+            --m->resident;
+        }
+        m->page[i] = (int16_t *) zero_page;
+    }
+    hvm_checkpoint_release(m->base);
+    m->base = NULL;
+}
+
+/* Copy the page holding w into one of the machine's own and return w's word, halts the machine if out of memory */
+static int16_t *page_alloc(hvm_machine *m, u16 w) {
+    u16 i = w >> PAGE_BITS;
+    int16_t *page = m->page[i] == zero_page ? calloc(PAGE_SIZE, sizeof(int16_t)) : malloc(PAGE_SIZE * sizeof(int16_t));
+
+    if (!page) {
+        m->running = 0;
+        return &m->sink;
+    }
+    if (m->page[i] != zero_page)
+        memcpy(page, m->page[i], PAGE_SIZE * sizeof(int16_t));
+    m->page[i] = m->own[i] = page;
+    ++m->resident;
+    return &page[w & (PAGE_SIZE - 1u)];
+}
+
+void hvm_destroy(hvm_machine *m) {
+    if (!m)
+        return;
+    page_release(m);
+    hvm_program_release(m->prog);
+    if (!m->ram_foreign)
+        free(m->ram);
+    free(m);
+}
+
+void hvm_attach(hvm_machine *m, hvm_program *prog) {
+    hvm_program_retain(prog);
+    hvm_program_release(m->prog);
+    m->prog = prog;
+    hvm_reset(m);
+}
+
+/* The machine's program if nobody else holds it, else a fresh copy of its symbols */
+static hvm_program *prog_private(hvm_machine *m) {
+    hvm_program *prog = m->prog;
+
+    if (atomic_load_explicit(&prog->refs, memory_order_acquire) == 1)
+        return prog;
+    if (!(prog = hvm_program_create(m->flags)))
+        return NULL;
+    if (m->prog->sym_count) {
+        if (!(prog->syms = malloc(sizeof(HVMSym) * m->prog->sym_count))) {
+            free(prog);
+            return NULL;
+        }
+        memcpy(prog->syms, m->prog->syms, sizeof(HVMSym) * m->prog->sym_count);
+        prog->sym_count = prog->sym_cap = m->prog->sym_count;
+    }
+    hvm_program_release(m->prog);
+    m->prog = prog;
+    return prog;
+}
+
+/* Decode ROM dependent tables once the program words are in place */
+static int load_finish(hvm_program *prog, int len) {
+    // end-of-program signature
+    prog->rom[len] = EOS;
+    prog->rom[ROM_SIZE] = EOS;
+    prog->rom_len = len;
+
+    memset(prog->xidx, 0, sizeof(prog->xidx));
+    // entry 0 marks "no fused op"
+    prog->xop_count = 1;
+
+    if (!(prog->flags & HVM_NO_FUSE))
+        xop_scan(prog);
+    if ((prog->flags & HVM_EMULATE_OS) && hle_install(prog))
+        return HVM_ERR_NOSYMS;
+    return HVM_OK;
+}
+
+int hvm_program_load_buffer(hvm_program *prog, const void *buf, size_t len) {
+    const u8 *p = buf;
+    size_t words;
+
+    if (len < P_OFF)
+        return HVM_ERR_FORMAT;
+    // jump program offset
+    words = (len - P_OFF) / 2;
+    if (words > ROM_SIZE)
+        return HVM_ERR_SIZE;
+
+    memset(prog->rom, 0, sizeof(prog->rom));
+    for (size_t i = 0; i < words; ++i)
+        prog->rom[i] = (u16) (p[P_OFF + 2 * i] << 8u | p[P_OFF + 2 * i + 1]);
+    return load_finish(prog, words);
+}
+
+/* Read whole, then checked like a buffer: a file refused leaves the loaded program as it was */
+int hvm_program_load_file(hvm_program *prog, const char *path) {
+    // one word more than fits, to tell a full ROM from an oversized one
+    size_t cap = P_OFF + 2 * (ROM_SIZE + 1);
+    u8 *buf = malloc(cap);
+    size_t len;
+    FILE *hexfp;
+    int err;
+
+    if (!buf)
+        return HVM_ERR_NOMEM;
+    if (!(hexfp = fopen(path, "rb"))) {
+        free(buf);
+        return HVM_ERR_IO;
+    }
+    len = fread(buf, 1, cap, hexfp);
+    err = ferror(hexfp) ? HVM_ERR_IO : hvm_program_load_buffer(prog, buf, len);
+    fclose(hexfp);
+    free(buf);
+    return err;
+}
+
+int hvm_load_buffer(hvm_machine *m, const void *buf, size_t len) {
+    hvm_program *prog = prog_private(m);
+    int err;
+
+    if (!prog)
+        return HVM_ERR_NOMEM;
+    if (!(err = hvm_program_load_buffer(prog, buf, len)))
+        hvm_reset(m);
+    return err;
+}
+
+int hvm_load_file(hvm_machine *m, const char *path) {
+    hvm_program *prog = prog_private(m);
+    int err;
+
+    if (!prog)
+        return HVM_ERR_NOMEM;
+    if (!(err = hvm_program_load_file(prog, path)))
+        hvm_reset(m);
+    return err;
+}
+
+void hvm_reset(hvm_machine *m) {
+    page_release(m);
+    memset(&m->hdt, 0, sizeof(m->hdt));
+    m->hdt.state = hvm_fetch;
+    m->running = 1;
+    m->kbd_idle = 0;
+    m->cover_prev = 0;
+    memset(&m->stats, 0, sizeof(m->stats));
+    if (m->prof)
+        ++m->prof[m->hdt.pc];
+    if (m->cover_bits)
+        cover_bit(m->cover_bits, HVM_COVER_ENTRY, m->hdt.pc);
+    m->block_entry = m->hdt.pc;
+    m->block_steps = 0;
+    m->trace_entry = m->hdt.pc;
+}
+
+/*
+ * Mark the jump ending the block, the last of the n words run from pc, and
+ * the entry of the next. A fused compare marks what its unfused sequence would:
+ * the conditional jump and the true branch, or the false branch, its jump
+ * past the true one and where that lands.
+ */
+static void cover_mark(hvm_machine *m, int pc, const HVMXop *x, int n, int landed) {
+    u8 *bits = m->cover_bits;
+
+    if (x && x->kind == xop_compare) {
+        // D;Jxx @SP A=M-1 M=0 @E 0;JMP, then the true branch at arg[1]
+        int j = x->arg[1] - 6;
+        if (n < x->len - 3) {
+            // and falls through to the end
+            cover_bit(bits, HVM_COVER_TAKEN, j);
+            cover_bit(bits, HVM_COVER_ENTRY, x->arg[1]);
+            return;
+        }
+        cover_bit(bits, HVM_COVER_NOT_TAKEN, j);
+        cover_bit(bits, HVM_COVER_ENTRY, j + 1);
+        cover_bit(bits, HVM_COVER_TAKEN, x->arg[1] - 1);
+    } else {
+        // other fused ops jump, if at all, with their last word
+        u16 w = m->prog->rom[pc + n - 1];
+        u16 prefix = w >> 13u;
+
+        if ((w & 0x7u) && (prefix == 0x7u || (prefix == 0x5u && (m->flags & HVM_EXTENDED))))
+            cover_bit(bits, landed || (w & 0x7u) == JMP ? HVM_COVER_TAKEN : HVM_COVER_NOT_TAKEN, pc + n - 1);
+    }
+    cover_bit(bits, HVM_COVER_ENTRY, m->hdt.pc);
+}
+
+/* Sample the RAM access of the C instr at pc, about to run with the address in A */
+static inline void heat_count(hvm_machine *m, int pc) {
+    u16 w = m->prog->rom[pc];
+    u16 prefix = w >> 13u;
+    u16 a = M_ADDR(m->hdt.A_REG);
+    int access;
+
+    if (w == EOS || !(prefix == 0x7u || (prefix == 0x5u && (m->flags & HVM_EXTENDED))))
+        return;
+    // 1 reads M, 2 writes it, 3 both
+    access = ((w >> 12u) & 1u) | (((w >> 3u) & DEST_M) << 1u);
+    if (!access || a < m->heat_lo || a > m->heat_hi)
+        return;
+    for (int i = 0; i < 2; ++i) {
+        if (!(access & (1 << i)) || --m->heat_left)
+            continue;
+        m->heat_left = m->heat_every;
+        ++m->heat[i * HVM_RAM_SIZE + a];
+    }
+}
+
+/* Count the edge from the last block into the one at pc, AFL style */
+static inline void cover_edge(hvm_machine *m) {
+    u16 cur = (u16) (m->hdt.pc * 40503u);
+
+    ++m->cover[(cur ^ m->cover_prev) & m->cover_mask];
+    m->cover_prev = cur >> 1u;
+}
+
+/*
+ * Classify the n ROM words from pc into st. Unconditional jumps are taken,
+ * the conditional one of a block is taken if it landed, or for a compare
+ * if it took the shorter, true, path.
+ */
+static inline void stats_count(const hvm_machine *m, int pc, const HVMXop *x, int n, int landed,
+                               struct hvm_stats *st) {
+    int taken = x && x->kind == xop_compare ? n < x->len - 3 : landed;
+
+    for (int i = pc; i < pc + n; ++i) {
+        u16 w = m->prog->rom[i];
+        u16 prefix = w >> 13u;
+
+        if (prefix == 0x7u || (prefix == 0x5u && (m->flags & HVM_EXTENDED))) {
+            ++st->c_instrs;
+            st->ram_reads += (w >> 12u) & 1u;
+            st->ram_writes += (w >> 3u) & DEST_M;
+            if ((w & 0x7u) == JMP)
+                ++st->jumps_taken;
+            else if (w & 0x7u)
+                ++*(taken ? &st->jumps_taken : &st->jumps_not_taken);
+        } else {
+            ++st->a_instrs;
+        }
+    }
+}
+
+/*
+ * Trace ring of chunks, each a 16 bit little endian count of the bytes
+ * used, itself included, and records of two varints: the run's start as
+ * a zigzag delta from where the previous record's run ended, 0 at the
+ * start of a chunk, and the run's length in words.
+ */
+#define TRACE_CHUNK 4096
+#define TRACE_RECORD 6
+
+struct hvm_trace {
+    u8 *ring;
+    u32 chunks;
+    u32 chunk;      // being written
+    u32 used;
+    u16 prev;
+};
+
+static inline void trace_put(u8 *chunk, u32 *used, unsigned v) {
+    while (v >= 0x80u) {
+        chunk[(*used)++] = (u8) (v | 0x80u);
+        v >>= 7u;
+    }
+    chunk[(*used)++] = (u8) v;
+}
+
+static __attribute__((noinline)) void trace_run(hvm_trace *t, u16 entry, u16 next) {
+    int16_t delta;
+    u8 *chunk;
+
+    if (t->used > TRACE_CHUNK - TRACE_RECORD) {
+        t->chunk = t->chunk + 1 == t->chunks ? 0 : t->chunk + 1;
+        t->used = 2;
+        t->prev = 0;
+        // a dump from a signal handler may come before the first record
+        t->ring[(size_t) t->chunk * TRACE_CHUNK] = 2;
+        t->ring[(size_t) t->chunk * TRACE_CHUNK + 1] = 0;
+    }
+    chunk = t->ring + (size_t) t->chunk * TRACE_CHUNK;
+    delta = (int16_t) (entry - t->prev);
+    trace_put(chunk, &t->used, (u16) ((u16) delta << 1u ^ (u16) (delta >> 15)));
+    trace_put(chunk, &t->used, (u16) (next - entry));
+    chunk[0] = (u8) t->used;
+    chunk[1] = (u8) (t->used >> 8u);
+    t->prev = next;
+}
+
+/* Instrumentation run() is specialized on: a trace alone, or anything with checks for each */
+enum probes {
+    probe_trace = 1,
+    probe_all
+};
+
+static inline int probes(const hvm_machine *m) {
+    if (m->cover || m->cover_bits || m->prof || m->hook || m->heat || (m->flags & HVM_STATS))
+        return probe_all;
+    return m->trace ? probe_trace : 0;
+}
+
+/*
+ * After pc ran as n instrs, through the fused op x or stepped (x NULL).
+ * Jump instrs, taken or not, end a block and so does landing elsewhere
+ * than the next word. Fused ops are classified by the words they stand
+ * for, the first n of them.
+ */
+static inline __attribute__((always_inline)) void probe(hvm_machine *m, int pc, const HVMXop *x, int n,
+                                                        struct hvm_stats *st) {
+    int landed = m->hdt.pc != pc + (x ? x->len : 1);
+    // a C instr leaves the machine in fetch state
+    int branch = x ? x->kind == xop_if_goto || x->kind == xop_compare : m->hdt.state == hvm_fetch && m->hdt.jmp;
+
+    if (!n)
+        return;
+    if (m->cover && (landed || branch))
+        cover_edge(m);
+    if (m->cover_bits && (landed || branch))
+        cover_mark(m, pc, x, n, landed);
+    if (m->prof && (landed || branch)) {
+        if (x && x->kind == xop_compare) {
+            // the entries its unfused sequence makes: the true branch, or the false one and the end
+            if (n < x->len - 3) {
+                ++m->prof[x->arg[1]];
+            } else {
+                ++m->prof[x->arg[1] - 5];
+                ++m->prof[x->arg[2]];
+            }
+        } else {
+            ++m->prof[m->hdt.pc];
+        }
+    }
+    if (m->flags & HVM_STATS)
+        stats_count(m, pc, x, n, landed, st);
+    if (m->hook) {
+        m->block_steps += n;
+        if (landed || branch) {
+            m->hook(m->hook_ctx, m, m->block_entry, PC_ADDR(pc + (x ? x->len : 1)), m->block_steps);
+            m->block_entry = m->hdt.pc;
+            m->block_steps = 0;
+        }
+    }
+}
+
+/*
+ * Run until halt or max_steps instrs. With to_block the run goes on past
+ * max_steps until control lands somewhere else than the next instr, i.e.
+ * it stops at the entry of a block. With probed every instr or fused op
+ * goes through probe(), counts are kept locally and added to the machine
+ * on the way out. Inlined with constant to_block and probed so hvm_run()
+ * carries none of it.
+ */
+static inline __attribute__((always_inline)) long run(hvm_machine *m, long max_steps, int to_block, int probed) {
+    const hvm_program *prog = m->prog;
+    struct hvm_stats st = {0};
+    long steps = 0;
+    const HVMXop *x;
+    int n, pc, len;
+    int landed = 0;
+    // straight line code would go on at next, it started at entry
+    int tracing = probed == probe_trace || (probed && m->trace);
+    int next = m->hdt.pc;
+    u16 entry = m->trace_entry;
+
+    while (m->running && (max_steps < 0 || steps < max_steps || (to_block && !landed))) {
+        pc = m->hdt.pc;
+        if (tracing && __builtin_expect(pc != next, 0)) {
+            trace_run(m->trace, entry, PC_ADDR(next));
+            entry = pc;
+        }
+        // RAM is sampled instr by instr, fused ops and OS routines run as their instrs
+        if (prog->xidx[pc] && !(probed == probe_all && m->heat)) {
+            x = &prog->xops[prog->xidx[pc]];
+            // a fused op must fit into what is left of the budget, x becomes the op that ran
+            if ((max_steps < 0 || to_block || x->len <= max_steps - steps) && (n = xop_exec(m, &x))) {
+                len = x ? x->len : 1;
+                steps += n;
+                next = pc + len;
+                // a compare jumps on either path, the trace keeps the one taken
+                if (tracing && x && x->kind == xop_compare) {
+                    if (n < x->len - 3) {
+                        trace_run(m->trace, entry, PC_ADDR(x->arg[1] - 5));
+                        entry = x->arg[1];
+                    } else {
+                        trace_run(m->trace, entry, PC_ADDR(x->arg[1]));
+                        entry = x->arg[2];
+                    }
+                }
+                if (to_block)
+                    landed = m->hdt.pc != pc + len;
+                if (probed == probe_all)
+                    probe(m, pc, x, n, &st);
+                continue;
+            }
+        }
+        if (probed == probe_all && m->heat)
+            heat_count(m, pc);
+        n = step(m);
+        steps += n;
+        next = pc + 1;
+        if (to_block)
+            landed = m->hdt.pc != pc + 1;
+        if (probed == probe_all)
+            probe(m, pc, NULL, n, &st);
+    }
+
+    if (tracing) {
+        if (m->hdt.pc != next) {
+            trace_run(m->trace, entry, PC_ADDR(next));
+            entry = m->hdt.pc;
+        }
+        // the run a machine halts in ends there
+        if (!m->running && entry != m->hdt.pc) {
+            trace_run(m->trace, entry, PC_ADDR(m->hdt.pc));
+            entry = m->hdt.pc;
+        }
+        m->trace_entry = entry;
+    }
+    // the block a machine halts in ends there
+    if (probed && m->hook && !m->running && m->block_steps) {
+        m->hook(m->hook_ctx, m, m->block_entry, PC_ADDR(m->hdt.pc), m->block_steps);
+        m->block_steps = 0;
+    }
+    if (probed && (m->flags & HVM_STATS)) {
+        m->stats.instrs += steps;
+        m->stats.a_instrs += st.a_instrs;
+        m->stats.c_instrs += st.c_instrs;
+        m->stats.jumps_taken += st.jumps_taken;
+        m->stats.jumps_not_taken += st.jumps_not_taken;
+        m->stats.ram_reads += st.ram_reads;
+        m->stats.ram_writes += st.ram_writes;
+    }
+    return steps;
+}
+
+long hvm_run(hvm_machine *m, long max_steps) {
+    switch (probes(m)) {
+        case probe_trace:
+            return run(m, max_steps, 0, probe_trace);
+        case probe_all:
+            return run(m, max_steps, 0, probe_all);
+        default:
+            return run(m, max_steps, 0, 0);
+    }
+}
+
+long hvm_run_slice(hvm_machine *m, long quantum) {
+    switch (probes(m)) {
+        case probe_trace:
+            return run(m, quantum, 1, probe_trace);
+        case probe_all:
+            return run(m, quantum, 1, probe_all);
+        default:
+            return run(m, quantum, 1, 0);
+    }
+}
+
+void hvm_get_stats(const hvm_machine *m, struct hvm_stats *stats) {
+    *stats = m->stats;
+}
+
+hvm_trace *hvm_trace_create(size_t bytes) {
+    hvm_trace *t = calloc(1, sizeof(hvm_trace));
+
+    if (!t)
+        return NULL;
+    t->chunks = bytes > TRACE_CHUNK ? bytes / TRACE_CHUNK : 1;
+    if (!(t->ring = calloc(t->chunks, TRACE_CHUNK))) {
+        free(t);
+        return NULL;
+    }
+    t->used = 2;
+    return t;
+}
+
+void hvm_trace_destroy(hvm_trace *t) {
+    if (!t)
+        return;
+    free(t->ring);
+    free(t);
+}
+
+void hvm_set_trace(hvm_machine *m, hvm_trace *t) {
+    m->trace = t;
+    m->trace_entry = m->hdt.pc;
+}
+
+/* write() until done, a signal may cut it short */
+static int write_all(int fd, const void *buf, size_t len) {
+    const u8 *p = buf;
+    ssize_t n;
+
+    while (len) {
+        if ((n = write(fd, p, len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int hvm_trace_dump(const hvm_trace *t, int fd) {
+    u8 head[16] = {'H', 'V', 'M', 'T'};
+    u32 fields[3] = {TRACE_CHUNK, t->chunks, t->chunk};
+
+    for (int i = 0; i < 3; ++i) {
+        for (int b = 0; b < 4; ++b)
+            head[4 + 4 * i + b] = (u8) (fields[i] >> (8u * b));
+    }
+    if (write_all(fd, head, sizeof(head)))
+        return -1;
+    return write_all(fd, t->ring, (size_t) t->chunks * TRACE_CHUNK);
+}
+
+void hvm_set_block_hook(hvm_machine *m, hvm_block_hook hook, void *ctx) {
+    m->hook = hook;
+    m->hook_ctx = ctx;
+    m->block_entry = m->hdt.pc;
+    m->block_steps = 0;
+}
+
+void hvm_set_profile(hvm_machine *m, uint64_t *counts) {
+    // the machine is at the entry of a block as far as counting goes
+    if ((m->prof = counts))
+        ++m->prof[m->hdt.pc];
+}
+
+void hvm_set_coverage(hvm_machine *m, uint8_t *map, size_t size) {
+    // largest power of 2 that fits, edges are 16 bit hashes
+    while (size & (size - 1))
+        size &= size - 1;
+    m->cover = size ? map : NULL;
+    m->cover_mask = (u16) (size > 0x10000 ? 0xFFFF : size - 1);
+    m->cover_prev = 0;
+}
+
+void hvm_set_cover_bits(hvm_machine *m, uint8_t *bits) {
+    // the machine is at the entry of a block
+    if ((m->cover_bits = bits))
+        cover_bit(bits, HVM_COVER_ENTRY, m->hdt.pc);
+}
+
+void hvm_set_heatmap(hvm_machine *m, uint64_t *counts, unsigned every, uint16_t lo, uint16_t hi) {
+    m->heat = counts;
+    m->heat_every = every ? every : 1;
+    m->heat_left = m->heat_every;
+    m->heat_lo = M_ADDR(lo);
+    m->heat_hi = M_ADDR(hi);
+}
+
+unsigned long hvm_kbd_idle(const hvm_machine *m) {
+    return m->kbd_idle;
+}
+
+int hvm_step(hvm_machine *m) {
+    return m->running ? step(m) : 0;
+}
+
+int hvm_halted(const hvm_machine *m) {
+    return !m->running;
+}
+
+int hvm_get_reg(const hvm_machine *m, enum hvm_reg reg) {
+    switch (reg) {
+        case HVM_REG_A:
+            return m->hdt.A_REG;
+        case HVM_REG_D:
+            return m->hdt.D_REG;
+        case HVM_REG_PC:
+            return m->hdt.pc;
+        default:
+            return 0;
+    }
+}
+
+void hvm_set_reg(hvm_machine *m, enum hvm_reg reg, int value) {
+    switch (reg) {
+        case HVM_REG_A:
+            m->hdt.A_REG = value;
+            break;
+        case HVM_REG_D:
+            m->hdt.D_REG = value;
+            break;
+        case HVM_REG_PC:
+            m->hdt.pc = PC_ADDR(value);
+            break;
+        default:
+            break;
+    }
+}
+
+int16_t hvm_read(const hvm_machine *m, uint16_t addr) {
+    return ram_read(m, addr);
+}
+
+void hvm_write(hvm_machine *m, uint16_t addr, int16_t value) {
+    // zero is what an unwritten page reads already
+    if (value || ram_read(m, addr))
+        *ram_ref(m, addr) = value;
+}
+
+int hvm_ram_resident(const hvm_machine *m) {
+    return m->resident;
+}
+
+uint64_t hvm_ram_digest(const hvm_machine *m, uint16_t lo, uint16_t hi) {
+    uint64_t h = 0, k;
+
+    for (unsigned a = lo; a <= hi; ++a) {
+        // zero words add nothing, pages never written are skipped whole
+        if (m->page[a >> PAGE_BITS] == zero_page) {
+            a |= PAGE_SIZE - 1u;
+            continue;
+        }
+        k = (a + 1) * 0x9e3779b97f4a7c15u;
+        h += (k ^ k >> 29u) * (u16) ram_read(m, a);
+    }
+    return h;
+}
+
+hvm_checkpoint *hvm_checkpoint_create(hvm_machine *m) {
+    hvm_checkpoint *cp = calloc(1, sizeof(hvm_checkpoint));
+
+    if (!cp)
+        return NULL;
+    atomic_init(&cp->refs, 1);
+    cp->prog = hvm_program_retain(m->prog);
+    cp->flags = m->flags;
+    cp->hdt = m->hdt;
+    cp->running = m->running;
+    cp->kbd_idle = m->kbd_idle;
+    memcpy(cp->page, m->page, sizeof(cp->page));
+
+    // pinned RAM stays with the machine, the checkpoint gets a copy
+    for (int i = 0; m->ram && i < RAM_PAGES; ++i) {
+        if (!(cp->own[i] = malloc(PAGE_SIZE * sizeof(int16_t)))) {
+            hvm_checkpoint_release(cp);
+            return NULL;
+        }
+        memcpy(cp->own[i], m->own[i], PAGE_SIZE * sizeof(int16_t));
+        cp->page[i] = cp->own[i];
+    }
+    if (m->ram)
+        return cp;
+
+    // the checkpoint takes over the machine's own pages, the machine goes on copy-on-write
+    memcpy(cp->own, m->own, sizeof(cp->own));
+    memset(m->own, 0, sizeof(m->own));
+    m->resident = 0;
+    cp->parent = m->base;
+    m->base = hvm_checkpoint_retain(cp);
+    return cp;
+}
+
+hvm_checkpoint *hvm_checkpoint_retain(hvm_checkpoint *cp) {
+    atomic_fetch_add_explicit(&cp->refs, 1, memory_order_relaxed);
+    return cp;
+}
+
+void hvm_checkpoint_release(hvm_checkpoint *cp) {
+    while (cp && atomic_fetch_sub_explicit(&cp->refs, 1, memory_order_acq_rel) == 1) {
+        hvm_checkpoint *parent = cp->parent;
+
+        for (int i = 0; i < RAM_PAGES; ++i)
+            free(cp->own[i]);
+        hvm_program_release(cp->prog);
+        free(cp);
+        cp = parent;
+    }
+}
+
+void hvm_fork(hvm_machine *m, hvm_checkpoint *cp) {
+    hvm_checkpoint_retain(cp);
+    page_release(m);
+    hvm_program_retain(cp->prog);
+    hvm_program_release(m->prog);
+    m->prog = cp->prog;
+    m->flags = cp->flags;
+    m->hdt = cp->hdt;
+    m->running = cp->running;
+    m->kbd_idle = cp->kbd_idle;
+    m->cover_prev = 0;
+    memset(&m->stats, 0, sizeof(m->stats));
+    if (m->prof)
+        ++m->prof[m->hdt.pc];
+    if (m->cover_bits)
+        cover_bit(m->cover_bits, HVM_COVER_ENTRY, m->hdt.pc);
+    m->block_entry = m->hdt.pc;
+    m->block_steps = 0;
+    m->trace_entry = m->hdt.pc;
+    if (m->ram) {
+        // pinned RAM stays where it is, the checkpoint's words are copied in
+        for (int i = 0; i < RAM_PAGES; ++i) {
+            if (cp->page[i] != zero_page)
+                memcpy(m->own[i], cp->page[i], PAGE_SIZE * sizeof(int16_t));
+        }
+        hvm_checkpoint_release(cp);
+        return;
+    }
+    memcpy(m->page, cp->page, sizeof(m->page));
+    m->base = cp;
+}
+
+/* Move RAM into ram, HVM_RAM_SIZE words, whoever owns it, or with adopt take ram's words */
+static void ram_move(hvm_machine *m, int16_t *ram, int adopt) {
+    for (int i = 0; i < RAM_PAGES; ++i) {
+        if (!adopt)
+            memmove(ram + i * PAGE_SIZE, m->page[i], PAGE_SIZE * sizeof(int16_t));
+        if (!m->ram)
+            free(m->own[i]);
+        m->page[i] = m->own[i] = ram + i * PAGE_SIZE;
+    }
+    hvm_checkpoint_release(m->base);
+    m->base = NULL;
+    if (!m->ram_foreign)
+        free(m->ram);
+    m->ram = ram;
+    m->resident = RAM_PAGES;
+}
+
+int16_t *hvm_ram_pin(hvm_machine *m) {
+    int16_t *ram;
+
+    if (m->ram)
+        return m->ram;
+    if (!(ram = malloc(RAM_SIZE * sizeof(int16_t))))
+        return NULL;
+    ram_move(m, ram, 0);
+    return ram;
+}
+
+void hvm_ram_map(hvm_machine *m, int16_t *ram) {
+    if (m->ram == ram)
+        return;
+    ram_move(m, ram, 0);
+    m->ram_foreign = 1;
+}
+
+void hvm_ram_adopt(hvm_machine *m, int16_t *ram) {
+    if (m->ram == ram)
+        return;
+    ram_move(m, ram, 1);
+    m->ram_foreign = 1;
+}
+
+uint16_t hvm_rom(const hvm_machine *m, uint16_t addr) {
+    return m->prog->rom[PC_ADDR(addr)];
+}
+
+int hvm_rom_len(const hvm_machine *m) {
+    return m->prog->rom_len;
+}
+
+uint32_t hvm_rom_hash(const hvm_machine *m) {
+    uint32_t h = 2166136261u;
+
+    // FNV-1a, low byte first
+    for (int pc = 0; pc < m->prog->rom_len; ++pc) {
+        h = (h ^ (m->prog->rom[pc] & 0xffu)) * 16777619u;
+        h = (h ^ (m->prog->rom[pc] >> 8u)) * 16777619u;
+    }
+    return h;
+}
+
+hvm_program *hvm_get_program(const hvm_machine *m) {
+    return m->prog;
+}
+
+const uint16_t *hvm_program_rom(const hvm_program *prog) {
+    return prog->rom;
+}
+
+const char *hvm_strerror(int status) {
+    switch (status) {
+        case HVM_OK:
+            return "success";
+        case HVM_ERR_IO:
+            return "unable to open file";
+        case HVM_ERR_FORMAT:
+            return "not a hex image";
+        case HVM_ERR_SIZE:
+            return "program does not fit into ROM";
+        case HVM_ERR_NOMEM:
+            return "out of memory";
+        case HVM_ERR_NOSYMS:
+            return "OS emulation needs a symbol map";
+        default:
+            return "unknown error";
+    }
+}
+
+static u16 fetch(hvm_machine *m) {
+    return m->prog->rom[m->hdt.pc++];
+}
+
+/* One fetch, decode, execute cycle, returns 0 once the end of program is reached */
+static int step(hvm_machine *m) {
+    // Fetch State
+    u16 instr = fetch(m);
+
+    if (instr == EOS) {
+        m->running = 0;
+        return 0;
+    }
+    // Decode State
+    decode(instr, m);
+    if (m->hdt.state == hvm_execute) {
+        m->hdt.state = hvm_fetch;
+        // Execute State
+        execute(m);
+    } else if (instr == HVM_KBD && !ram_read(m, HVM_KBD)) {
+        // keyboard polled word by word, fused polls count in xop_exec()
+        ++m->kbd_idle;
+    }
+    return 1;
+}
+
+static void decode(u16 instr, hvm_machine *m) {
+    HVMData *hdt = &m->hdt;
+
+    // check instr first significant 3 bits.If 111 it is C instr,otherwise A instr
+    // In extended ISA mode 101 is a C instr too
+    u8 prefix = (instr & 0xE000u) >> 13u;
+    if ((prefix ^ 0x7u) && !((m->flags & HVM_EXTENDED) && prefix == 0x5u)) {
+        hdt->state = hvm_decode;
+        hdt->A_REG = instr;
+        return;
+    }
+    // extract comp,dest,jmp parts of instr
+    hdt->comp = EmitComp(instr);     // 1111111111000000
+    hdt->dest = EmitDest(instr);     // 0000000000111000
+    hdt->jmp =  EmitJmp(instr);      // 0000000000000111
+
+    // turn machine state execute
+    hdt->state = hvm_execute;
+}
+
+/* Compute the comp part of a C instr, unknown comp codes halt the machine */
+static int16_t alu(hvm_machine *m) {
+    HVMData *hdt = &m->hdt;
+    int16_t a = hdt->A_REG;
+    int16_t d = hdt->D_REG;
+
+    switch (hdt->comp) {
+        case COMP_ZERO:
+            return 0x0;
+        case COMP_ONE:
+            return 0x1;
+        case COMP_MINUS_1:
+            return -1;
+        case COMP_D:
+            return d;
+        case COMP_A:
+            return a;
+        case COMP_NOT_D:
+            return ~d;
+        case COMP_NOT_A:
+            return ~a;
+        case COMP_MINUS_D:
+            return -d;
+        case COMP_MINUS_A:
+            return -a;
+        case COMP_D_PLUS_1:
+            return d + 1;
+        case COMP_A_PLUS_1:
+            return a + 1;
+        case COMP_D_MINUS_1:
+            return d - 1;
+        case COMP_A_MINUS_1:
+            return a - 1;
+        case COMP_D_PLUS_A:
+            return d + a;
+        case COMP_D_MINUS_A:
+            return d - a;
+        case COMP_A_MINUS_D:
+            return a - d;
+        case COMP_D_AND_A:
+            return d & a;
+        case COMP_D_OR_A:
+            return d | a;
+        case COMP_M:
+            return ram_read(m, a);
+        case COMP_NOT_M:
+            return ~ram_read(m, a);
+        case COMP_MINUS_M:
+            return -ram_read(m, a);
+        case COMP_M_PLUS_1:
+            return ram_read(m, a) + 1;
+        case COMP_M_MINUS_1:
+            return ram_read(m, a) - 1;
+        case COMP_D_PLUS_M:
+            return d + ram_read(m, a);
+        case COMP_D_MINUS_M:
+            return d - ram_read(m, a);
+        case COMP_M_MINUS_D:
+            return ram_read(m, a) - d;
+        case COMP_D_AND_M:
+            return d & ram_read(m, a);
+        case COMP_D_OR_M:
+            return d | ram_read(m, a);
+        case COMP_A_SHR:
+            return a >> 1;
+        case COMP_D_SHR:
+            return d >> 1;
+        case COMP_M_SHR:
+            return ram_read(m, a) >> 1;
+        case COMP_A_SHL:
+            return (u16) a << 1u;
+        case COMP_D_SHL:
+            return (u16) d << 1u;
+        case COMP_M_SHL:
+            return (u16) ram_read(m, a) << 1u;
+        case COMP_D_MUL_A:
+            return d * a;
+        case COMP_D_MUL_M:
+            return d * ram_read(m, a);
+        default:
+            m->running = 0;
+            return 0x0;
+    }
+}
+
+static int jump_taken(u8 jmp, int16_t out) {
+    return ((jmp & JGT) && out > 0) ||
+           ((jmp & JEQ) && out == 0) ||
+           ((jmp & JLT) && out < 0);
+}
+
+static void execute(hvm_machine *m) {
+    HVMData *hdt = &m->hdt;
+    int16_t a = hdt->A_REG;
+    int16_t out = alu(m);
+
+    if (!m->running)
+        return;
+
+    // M is addressed by A as it was before this instr
+    if (hdt->dest & DEST_M)
+        *ram_ref(m, a) = out;
+    if (hdt->dest & DEST_A)
+        hdt->A_REG = out;
+    if (hdt->dest & DEST_D)
+        hdt->D_REG = out;
+
+    if (jump_taken(hdt->jmp, out))
+        hdt->pc = PC_ADDR(a);
+}
+
+/*
+ * Lockstep execution
+ *
+ * Up to HVM_LANES machines on the same program share one instr stream.
+ * A, D and PC of every lane are held in vectors, each instr is decoded
+ * once and executed for all lanes with GCC vector extensions, which
+ * compile to one AVX2 op per step on targets that have it (16 x 16 bit
+ * lanes) and to pairs of SSE2 ops otherwise. Only M loads and stores go
+ * lane by lane, every machine has its own RAM. Lanes whose jumps diverge
+ * are masked off: the group always runs the lowest PC any lane waits at,
+ * so lanes left behind get picked up once the others catch up with them.
+ * Fused ops and OS emulation are not used here, every lane steps ROM.
+ */
+typedef uint16_t lane_v __attribute__((vector_size(HVM_LANES * sizeof(uint16_t))));
+typedef int16_t lane_s __attribute__((vector_size(HVM_LANES * sizeof(int16_t))));
+
+/* Lane registers, passed by pointer so vectors never cross a call by value */
+typedef struct {
+    lane_v a, d, m;
+    lane_v out;
+    lane_v t;
+} HVMLanes;
+
+/* alu() for all lanes at once, returns 0 for unknown comp codes */
+static int lane_alu(u16 comp, HVMLanes *v) {
+    const lane_v zero = {0};
+
+    switch (comp) {
+        case COMP_ZERO:
+            v->out = zero;
+            break;
+        case COMP_ONE:
+            v->out = zero + 1;
+            break;
+        case COMP_MINUS_1:
+            v->out = ~zero;
+            break;
+        case COMP_D:
+            v->out = v->d;
+            break;
+        case COMP_A:
+            v->out = v->a;
+            break;
+        case COMP_NOT_D:
+            v->out = ~v->d;
+            break;
+        case COMP_NOT_A:
+            v->out = ~v->a;
+            break;
+        case COMP_MINUS_D:
+            v->out = -v->d;
+            break;
+        case COMP_MINUS_A:
+            v->out = -v->a;
+            break;
+        case COMP_D_PLUS_1:
+            v->out = v->d + 1;
+            break;
+        case COMP_A_PLUS_1:
+            v->out = v->a + 1;
+            break;
+        case COMP_D_MINUS_1:
+            v->out = v->d - 1;
+            break;
+        case COMP_A_MINUS_1:
+            v->out = v->a - 1;
+            break;
+        case COMP_D_PLUS_A:
+            v->out = v->d + v->a;
+            break;
+        case COMP_D_MINUS_A:
+            v->out = v->d - v->a;
+            break;
+        case COMP_A_MINUS_D:
+            v->out = v->a - v->d;
+            break;
+        case COMP_D_AND_A:
+            v->out = v->d & v->a;
+            break;
+        case COMP_D_OR_A:
+            v->out = v->d | v->a;
+            break;
+        case COMP_M:
+            v->out = v->m;
+            break;
+        case COMP_NOT_M:
+            v->out = ~v->m;
+            break;
+        case COMP_MINUS_M:
+            v->out = -v->m;
+            break;
+        case COMP_M_PLUS_1:
+            v->out = v->m + 1;
+            break;
+        case COMP_M_MINUS_1:
+            v->out = v->m - 1;
+            break;
+        case COMP_D_PLUS_M:
+            v->out = v->d + v->m;
+            break;
+        case COMP_D_MINUS_M:
+            v->out = v->d - v->m;
+            break;
+        case COMP_M_MINUS_D:
+            v->out = v->m - v->d;
+            break;
+        case COMP_D_AND_M:
+            v->out = v->d & v->m;
+            break;
+        case COMP_D_OR_M:
+            v->out = v->d | v->m;
+            break;
+        case COMP_A_SHR:
+            v->out = (lane_v) ((lane_s) v->a >> 1);
+            break;
+        case COMP_D_SHR:
+            v->out = (lane_v) ((lane_s) v->d >> 1);
+            break;
+        case COMP_M_SHR:
+            v->out = (lane_v) ((lane_s) v->m >> 1);
+            break;
+        case COMP_A_SHL:
+            v->out = v->a << 1;
+            break;
+        case COMP_D_SHL:
+            v->out = v->d << 1;
+            break;
+        case COMP_M_SHL:
+            v->out = v->m << 1;
+            break;
+        case COMP_D_MUL_A:
+            v->out = v->d * v->a;
+            break;
+        case COMP_D_MUL_M:
+            v->out = v->d * v->m;
+            break;
+        default:
+            return 0;
+    }
+    return 1;
+}
+
+/* Lanes whose out satisfies jmp */
+static void lane_jump(u8 jmp, HVMLanes *v) {
+    lane_v t = {0};
+
+    if (jmp & JGT)
+        t |= (lane_v) ((lane_s) v->out > 0);
+    if (jmp & JEQ)
+        t |= (lane_v) (v->out == 0);
+    if (jmp & JLT)
+        t |= (lane_v) ((lane_s) v->out < 0);
+    v->t = t;
+}
+
+/* x where mask is set, y elsewhere */
+#define LANE_SEL(mask, x, y) (((x) & (mask)) | ((y) & ~(mask)))
+
+/* Run up to HVM_LANES machines on the same program as one group */
+static long lockstep_group(hvm_machine **ms, int n, long max_steps, long *counts) {
+    const hvm_program *prog = ms[0]->prog;
+    const int ext = ms[0]->flags & HVM_EXTENDED;
+    const lane_v zero = {0};
+    hvm_machine *lm[HVM_LANES];
+    long steps[HVM_LANES] = {0};
+    HVMLanes v;
+    lane_v pc, act;
+    unsigned live = 0, on;
+    long total = 0, left, run;
+    int cur, wait, halt, jumped;
+
+    for (int l = 0; l < HVM_LANES; ++l) {
+        // lanes past n shadow lane 0 and are never active
+        hvm_machine *m = ms[l < n ? l : 0];
+        lm[l] = m;
+        v.a[l] = m->hdt.A_REG;
+        v.d[l] = m->hdt.D_REG;
+        pc[l] = m->hdt.pc;
+        if (l < n && m->running)
+            live |= 1u << l;
+    }
+
+    for (;;) {
+        // pick the lowest PC a lane within budget waits at
+        cur = -1;
+        for (int l = 0; l < HVM_LANES; ++l) {
+            if ((live >> l & 1u) && (max_steps < 0 || steps[l] < max_steps) && (cur < 0 || pc[l] < cur))
+                cur = pc[l];
+        }
+        if (cur < 0)
+            break;
+        on = 0;
+        act = zero;
+        wait = -1;
+        left = -1;
+        for (int l = 0; l < HVM_LANES; ++l) {
+            if (!(live >> l & 1u) || (max_steps >= 0 && steps[l] >= max_steps))
+                continue;
+            if (pc[l] == cur) {
+                on |= 1u << l;
+                act[l] = 0xFFFF;
+                if (max_steps >= 0 && (left < 0 || max_steps - steps[l] < left))
+                    left = max_steps - steps[l];
+            } else if (wait < 0 || pc[l] < wait) {
+                wait = pc[l];
+            }
+        }
+
+        // run the active lanes until they jump, halt, run into a waiting lane or out of budget
+        halt = jumped = 0;
+        for (run = 0; left < 0 || run < left;) {
+            u16 instr = prog->rom[cur];
+            u8 prefix = (instr & 0xE000u) >> 13u;
+
+            if (instr == EOS) {
+                ++cur;
+                halt = 1;
+                break;
+            }
+            ++run;
+            if ((prefix ^ 0x7u) && !(ext && prefix == 0x5u)) {
+                v.a = LANE_SEL(act, zero + instr, v.a);
+            } else {
+                u16 comp = EmitComp(instr);
+                u8 dest = EmitDest(instr);
+                u8 jmp = EmitJmp(instr);
+
+                // A bit, every M comp has it set
+                if (comp & 0x40u) {
+                    for (int l = 0; l < HVM_LANES; ++l)
+                        v.m[l] = ram_read(lm[l], v.a[l]);
+                }
+                if (!lane_alu(comp, &v)) {
+                    ++cur;
+                    halt = 1;
+                    break;
+                }
+                if (dest & DEST_M) {
+                    for (int l = 0; l < HVM_LANES; ++l) {
+                        if (on >> l & 1u)
+                            *ram_ref(lm[l], v.a[l]) = v.out[l];
+                    }
+                }
+                if (jmp) {
+                    // jump to A as it was before this instr
+                    lane_jump(jmp, &v);
+                    v.t &= act;
+                    pc = LANE_SEL(v.t, v.a & (ROM_SIZE - 1u), LANE_SEL(act, zero + (u16) (cur + 1), pc));
+                    jumped = 1;
+                }
+                if (dest & DEST_A)
+                    v.a = LANE_SEL(act, v.out, v.a);
+                if (dest & DEST_D)
+                    v.d = LANE_SEL(act, v.out, v.d);
+                if (jumped)
+                    break;
+            }
+            if (++cur == wait)
+                break;
+        }
+
+        if (!jumped)
+            pc = LANE_SEL(act, zero + (u16) cur, pc);
+        for (int l = 0; l < HVM_LANES; ++l) {
+            if (!(on >> l & 1u))
+                continue;
+            steps[l] += run;
+            total += run;
+            if (halt)
+                ms[l]->running = 0;
+        }
+        if (halt)
+            live &= ~on;
+    }
+
+    for (int l = 0; l < n; ++l) {
+        ms[l]->hdt.A_REG = v.a[l];
+        ms[l]->hdt.D_REG = v.d[l];
+        ms[l]->hdt.pc = pc[l];
+        if (counts)
+            counts[l] = steps[l];
+    }
+    return total;
+}
+
+/* Run a gathered group, spreading its per lane counts back to the callers' indices */
+static long lockstep_flush(hvm_machine **group, const int *index, int k, long max_steps, long *counts) {
+    long group_counts[HVM_LANES];
+    long steps = lockstep_group(group, k, max_steps, group_counts);
+
+    for (int l = 0; counts && l < k; ++l)
+        counts[index[l]] = group_counts[l];
+    return steps;
+}
+
+long hvm_run_lockstep(hvm_machine **ms, int n, long max_steps, long *counts) {
+    hvm_machine *group[HVM_LANES];
+    int index[HVM_LANES];
+    long steps = 0, c;
+    int k = 0;
+
+    for (int i = 0; i < n; ++i) {
+        if (ms[i]->prog != ms[0]->prog || ms[i]->flags != ms[0]->flags) {
+            steps += c = hvm_run(ms[i], max_steps);
+            if (counts)
+                counts[i] = c;
+            continue;
+        }
+        index[k] = i;
+        group[k++] = ms[i];
+        if (k == HVM_LANES) {
+            steps += lockstep_flush(group, index, k, max_steps, counts);
+            k = 0;
+        }
+    }
+    if (k)
+        steps += lockstep_flush(group, index, k, max_steps, counts);
+    return steps;
+}
+
+/*
+ * Fused ops
+ *
+ * The VM translator emits call, return and every stack command as a fixed
+ * instr sequence. xop_scan() recognizes them in ROM once at load time and
+ * the run loop executes each one as a single native op. Handlers replay
+ * the sequence's RAM and register effects in order, SP included, so the
+ * machine state after a fused op is the same as after stepping through
+ * its instrs.
+ */
+
+/* Match helpers, advance *pc past the matched words */
+static int want(const hvm_program *prog, int *pc, u16 w) {
+    if (*pc >= prog->rom_len || prog->rom[*pc] != w)
+        return 0;
+    ++*pc;
+    return 1;
+}
+
+static int want_a(const hvm_program *prog, int *pc, u16 *val) {
+    if (*pc >= prog->rom_len || (prog->rom[*pc] & 0x8000u))
+        return 0;
+    *val = prog->rom[(*pc)++];
+    return 1;
+}
+
+/* *SP = D, SP++, returns which of the two common forms matched */
+static int want_push_d(const hvm_program *prog, int *pc) {
+    int p = *pc;
+
+    // @SP A=M M=D @SP M=M+1
+    if (want(prog, &p, R_SP) && want(prog, &p, C_INSTR(COMP_M, DEST_A, 0)) &&
+        want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)) && want(prog, &p, R_SP) &&
+        want(prog, &p, C_INSTR(COMP_M_PLUS_1, DEST_M, 0))) {
+        *pc = p;
+        return 1;
+    }
+    p = *pc;
+    // @SP AM=M+1 A=A-1 M=D
+    if (want(prog, &p, R_SP) && want(prog, &p, C_INSTR(COMP_M_PLUS_1, DEST_AM, 0)) &&
+        want(prog, &p, C_INSTR(COMP_A_MINUS_1, DEST_A, 0)) &&
+        want(prog, &p, C_INSTR(COMP_D, DEST_M, 0))) {
+        *pc = p;
+        return 2;
+    }
+    return 0;
+}
+
+/* @SP AM=M-1 D=M, D = *(--SP) */
+static int want_pop_d(const hvm_program *prog, int *pc) {
+    return want(prog, pc, R_SP) && want(prog, pc, C_INSTR(COMP_M_MINUS_1, DEST_AM, 0)) &&
+           want(prog, pc, C_INSTR(COMP_M, DEST_D, 0));
+}
+
+/* D = *(base + i), either @i D=A @base A=D+M or @base D=M @i A=D+A */
+static int want_load_indexed(const hvm_program *prog, int *pc, u16 *i, u16 *base) {
+    int p = *pc;
+
+    if (want_a(prog, &p, i) && want(prog, &p, C_INSTR(COMP_A, DEST_D, 0)) && want_a(prog, &p, base) &&
+        want(prog, &p, C_INSTR(COMP_D_PLUS_M, DEST_A, 0)) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0))) {
+        *pc = p;
+        return 1;
+    }
+    p = *pc;
+    if (want_a(prog, &p, base) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) && want_a(prog, &p, i) &&
+        want(prog, &p, C_INSTR(COMP_D_PLUS_A, DEST_A, 0)) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0))) {
+        *pc = p;
+        return 1;
+    }
+    return 0;
+}
+
+/* D = base + i, either @i D=A @base D=D+M or @base D=M @i D=D+A */
+static int want_addr_indexed(const hvm_program *prog, int *pc, u16 *i, u16 *base) {
+    int p = *pc;
+
+    if (want_a(prog, &p, i) && want(prog, &p, C_INSTR(COMP_A, DEST_D, 0)) && want_a(prog, &p, base) &&
+        want(prog, &p, C_INSTR(COMP_D_PLUS_M, DEST_D, 0))) {
+        *pc = p;
+        return 1;
+    }
+    p = *pc;
+    if (want_a(prog, &p, base) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) && want_a(prog, &p, i) &&
+        want(prog, &p, C_INSTR(COMP_D_PLUS_A, DEST_D, 0))) {
+        *pc = p;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * call f n:
+ *   push return-address, LCL, ARG, THIS, THAT
+ *   ARG = SP - 5 - n, LCL = SP, goto f
+ */
+static int match_call(const hvm_program *prog, int pc, HVMXop *x) {
+    int p = pc;
+    int q, form;
+    u16 ret, k, f;
+    u16 sub = 0;
+
+    if (!want_a(prog, &p, &ret) || !want(prog, &p, C_INSTR(COMP_A, DEST_D, 0)) || !(form = want_push_d(prog, &p)))
+        return 0;
+    for (u16 seg = R_LCL; seg <= R_THAT; ++seg) {
+        if (!want(prog, &p, seg) || !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) || want_push_d(prog, &p) != form)
+            return 0;
+    }
+    // @SP D=M, then any number of @k D=D-A, @ARG M=D
+    if (!want(prog, &p, R_SP) || !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)))
+        return 0;
+    for (q = p; want_a(prog, &q, &k) && want(prog, &q, C_INSTR(COMP_D_MINUS_A, DEST_D, 0)); p = q)
+        sub += k;
+    if (!want(prog, &p, R_ARG) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    if (!want(prog, &p, R_SP) || !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) ||
+        !want(prog, &p, R_LCL) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    if (!want_a(prog, &p, &f) || !want(prog, &p, C_INSTR(COMP_ZERO, 0, JMP)))
+        return 0;
+
+    x->kind = xop_call;
+    x->form = form;
+    x->arg[0] = ret;
+    x->arg[1] = sub;
+    x->arg[2] = f;
+    return p - pc;
+}
+
+/*
+ * return:
+ *   FRAME = LCL, RET = *(FRAME - 5), *ARG = pop(), SP = ARG + 1
+ *   restore THAT, THIS, ARG, LCL from FRAME - 1 .. FRAME - 4, goto RET
+ */
+static int match_return(const hvm_program *prog, int pc, HVMXop *x) {
+    int p = pc;
+    u16 fr, rr;
+
+    if (!want(prog, &p, R_LCL) || !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) ||
+        !want_a(prog, &p, &fr) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    if (!want(prog, &p, 5) || !want(prog, &p, C_INSTR(COMP_D_MINUS_A, DEST_A, 0)) ||
+        !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) ||
+        !want_a(prog, &p, &rr) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    if (!want_pop_d(prog, &p) || !want(prog, &p, R_ARG) ||
+        !want(prog, &p, C_INSTR(COMP_M, DEST_A, 0)) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    if (!want(prog, &p, R_ARG) || !want(prog, &p, C_INSTR(COMP_M_PLUS_1, DEST_D, 0)) ||
+        !want(prog, &p, R_SP) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+        return 0;
+    for (u16 seg = R_THAT; seg >= R_LCL; --seg) {
+        if (!want(prog, &p, fr) || !want(prog, &p, C_INSTR(COMP_M_MINUS_1, DEST_AM, 0)) ||
+            !want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) ||
+            !want(prog, &p, seg) || !want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)))
+            return 0;
+    }
+    if (!want(prog, &p, rr) || !want(prog, &p, C_INSTR(COMP_M, DEST_A, 0)) ||
+        !want(prog, &p, C_INSTR(COMP_ZERO, 0, JMP)))
+        return 0;
+
+    x->kind = xop_return;
+    x->arg[0] = fr;
+    x->arg[1] = rr;
+    return p - pc;
+}
+
+/* push constant c, push local/argument/this/that i, push temp/pointer/static i */
+static int match_push(const hvm_program *prog, int pc, HVMXop *x) {
+    int p = pc;
+
+    if (want_a(prog, &p, &x->arg[0]) && want(prog, &p, C_INSTR(COMP_A, DEST_D, 0)) &&
+        (x->form = want_push_d(prog, &p))) {
+        x->kind = xop_push_const;
+        return p - pc;
+    }
+    p = pc;
+    if (want_load_indexed(prog, &p, &x->arg[0], &x->arg[1]) && (x->form = want_push_d(prog, &p))) {
+        x->kind = xop_push_seg;
+        return p - pc;
+    }
+    p = pc;
+    if (want_a(prog, &p, &x->arg[0]) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0)) &&
+        (x->form = want_push_d(prog, &p))) {
+        x->kind = xop_push_mem;
+        return p - pc;
+    }
+    return 0;
+}
+
+/* pop local/argument/this/that i through a temp register, pop temp/pointer/static i */
+static int match_pop(const hvm_program *prog, int pc, HVMXop *x) {
+    int p = pc;
+
+    if (want_addr_indexed(prog, &p, &x->arg[0], &x->arg[1]) && want_a(prog, &p, &x->arg[2]) &&
+        want(prog, &p, C_INSTR(COMP_D, DEST_M, 0)) && want_pop_d(prog, &p) && want(prog, &p, x->arg[2]) &&
+        want(prog, &p, C_INSTR(COMP_M, DEST_A, 0)) && want(prog, &p, C_INSTR(COMP_D, DEST_M, 0))) {
+        x->kind = xop_pop_seg;
+        return p - pc;
+    }
+    p = pc;
+    if (want_pop_d(prog, &p) && want_a(prog, &p, &x->arg[0]) && want(prog, &p, C_INSTR(COMP_D, DEST_M, 0))) {
+        x->kind = xop_pop_mem;
+        return p - pc;
+    }
+    return 0;
+}
+
+/* add, sub, and, or, neg, not, eq, gt, lt, if-goto */
+static int match_arith(const hvm_program *prog, int pc, HVMXop *x) {
+    static const u16 binary[] = {COMP_D_PLUS_M, COMP_M_MINUS_D, COMP_D_AND_M, COMP_D_OR_M};
+    static const u16 unary[] = {COMP_MINUS_M, COMP_NOT_M};
+    static const u8 cmp[] = {JEQ, JGT, JLT};
+    int p = pc;
+    int q;
+
+    // @SP AM=M-1 D=M A=A-1, then M=D+M or D=M-D @T D;Jxx ...
+    if (want_pop_d(prog, &p) && want(prog, &p, C_INSTR(COMP_A_MINUS_1, DEST_A, 0))) {
+        for (size_t i = 0; i < sizeof(binary) / sizeof(binary[0]); ++i) {
+            q = p;
+            if (want(prog, &q, C_INSTR(binary[i], DEST_M, 0))) {
+                x->kind = xop_binary;
+                x->arg[0] = binary[i];
+                return q - pc;
+            }
+        }
+        // @T D;Jxx @SP A=M-1 M=0 @E 0;JMP (T) @SP A=M-1 M=-1 (E)
+        if (!want(prog, &p, C_INSTR(COMP_M_MINUS_D, DEST_D, 0)) || !want_a(prog, &p, &x->arg[1]))
+            return 0;
+        for (size_t i = 0; i < sizeof(cmp) / sizeof(cmp[0]); ++i) {
+            q = p;
+            if (!want(prog, &q, C_INSTR(COMP_D, 0, cmp[i])) || !want(prog, &q, R_SP) ||
+                !want(prog, &q, C_INSTR(COMP_M_MINUS_1, DEST_A, 0)) || !want(prog, &q, C_INSTR(COMP_ZERO, DEST_M, 0)) ||
+                !want_a(prog, &q, &x->arg[2]) || !want(prog, &q, C_INSTR(COMP_ZERO, 0, JMP)) || q != x->arg[1] ||
+                !want(prog, &q, R_SP) || !want(prog, &q, C_INSTR(COMP_M_MINUS_1, DEST_A, 0)) ||
+                !want(prog, &q, C_INSTR(COMP_MINUS_1, DEST_M, 0)) || q != x->arg[2])
+                continue;
+            x->kind = xop_compare;
+            x->arg[0] = cmp[i];
+            return q - pc;
+        }
+        return 0;
+    }
+    p = pc;
+    // @SP A=M-1 M=-M
+    if (want(prog, &p, R_SP) && want(prog, &p, C_INSTR(COMP_M_MINUS_1, DEST_A, 0))) {
+        for (size_t i = 0; i < sizeof(unary) / sizeof(unary[0]); ++i) {
+            q = p;
+            if (want(prog, &q, C_INSTR(unary[i], DEST_M, 0))) {
+                x->kind = xop_unary;
+                x->arg[0] = unary[i];
+                return q - pc;
+            }
+        }
+        return 0;
+    }
+    p = pc;
+    // @SP AM=M-1 D=M @L D;JNE
+    if (want_pop_d(prog, &p) && want_a(prog, &p, &x->arg[0]) && want(prog, &p, C_INSTR(COMP_D, 0, JNE))) {
+        x->kind = xop_if_goto;
+        return p - pc;
+    }
+    return 0;
+}
+
+/* @KBD D=M, fused only to notice keyboard polling */
+static int match_kbd(const hvm_program *prog, int pc, HVMXop *x) {
+    int p = pc;
+
+    if (want(prog, &p, HVM_KBD) && want(prog, &p, C_INSTR(COMP_M, DEST_D, 0))) {
+        x->kind = xop_kbd;
+        return p - pc;
+    }
+    return 0;
+}
+
+static void xop_scan(hvm_program *prog) {
+    HVMXop x;
+    int len;
+
+    for (int pc = 0; pc < prog->rom_len && prog->xop_count < ROM_SIZE / 2;) {
+        memset(&x, 0, sizeof(x));
+        if ((len = match_call(prog, pc, &x)) || (len = match_return(prog, pc, &x)) ||
+            (len = match_push(prog, pc, &x)) || (len = match_pop(prog, pc, &x)) ||
+            (len = match_arith(prog, pc, &x)) || (len = match_kbd(prog, pc, &x))) {
+            x.len = len;
+            prog->xops[prog->xop_count] = x;
+            prog->xidx[pc] = prog->xop_count++;
+            pc += len;
+        } else {
+            ++pc;
+        }
+    }
+}
+
+/* Push D in the given form, leaves A where the instr sequence would */
+static void xop_push(hvm_machine *m, int form, int16_t d) {
+    HVMData *hdt = &m->hdt;
+    int16_t a;
+
+    if (form == 1) {
+        a = ram_read(m, R_SP);
+        *ram_ref(m, a) = d;
+        ++*ram_ref(m, R_SP);
+        a = R_SP;
+    } else {
+        a = ++*ram_ref(m, R_SP);
+        --a;
+        *ram_ref(m, a) = d;
+    }
+    hdt->A_REG = a;
+    hdt->D_REG = d;
+}
+
+/* Pop into D, A = SP */
+static void xop_pop(hvm_machine *m) {
+    HVMData *hdt = &m->hdt;
+
+    hdt->A_REG = --*ram_ref(m, R_SP);
+    hdt->D_REG = ram_read(m, hdt->A_REG);
+}
+
+/* Run the last instr of a stack op through the ALU */
+static void xop_alu(hvm_machine *m, u16 comp, u8 dest, u8 jmp) {
+    HVMData *hdt = &m->hdt;
+
+    hdt->comp = comp;
+    hdt->dest = dest;
+    hdt->jmp = jmp;
+    execute(m);
+}
+
+/* Return through FRAME and RET temp registers fr and rr */
+static void vm_return(hvm_machine *m, u16 fr, u16 rr) {
+    HVMData *hdt = &m->hdt;
+    int16_t d = ram_read(m, R_LCL);
+
+    *ram_ref(m, fr) = d;
+    d = ram_read(m, d - 5);
+    *ram_ref(m, rr) = d;
+    xop_pop(m);
+    *ram_ref(m, ram_read(m, R_ARG)) = hdt->D_REG;
+    *ram_ref(m, R_SP) = ram_read(m, R_ARG) + 1;
+    for (u16 seg = R_THAT; seg >= R_LCL; --seg) {
+        --*ram_ref(m, fr);
+        d = ram_read(m, ram_read(m, fr));
+        *ram_ref(m, seg) = d;
+    }
+    hdt->A_REG = ram_read(m, rr);
+    hdt->D_REG = d;
+    hdt->pc = PC_ADDR(hdt->A_REG);
+}
+
+/*
+ * Run the fused op *xp, returns the number of instrs it stood for on the
+ * path taken, or 0 if the op declined and ROM should be stepped instead.
+ * An emulated OS routine counts as a single instr, the word at its entry,
+ * and leaves *xp NULL; one that declined leaves there the op it fell back
+ * to.
+ */
+static int xop_exec(hvm_machine *m, const HVMXop **xp) {
+    const HVMXop *x = *xp;
+    HVMData *hdt = &m->hdt;
+    int pc = hdt->pc + x->len;
+    int n = x->len;
+    int16_t d;
+
+    switch (x->kind) {
+        case xop_call:
+            xop_push(m, x->form, x->arg[0]);
+            for (u16 seg = R_LCL; seg <= R_THAT; ++seg)
+                xop_push(m, x->form, ram_read(m, seg));
+            *ram_ref(m, R_ARG) = ram_read(m, R_SP) - x->arg[1];
+            d = ram_read(m, R_SP);
+            *ram_ref(m, R_LCL) = d;
+            hdt->A_REG = x->arg[2];
+            hdt->D_REG = d;
+            pc = PC_ADDR(hdt->A_REG);
+            break;
+        case xop_return:
+            vm_return(m, x->arg[0], x->arg[1]);
+            pc = hdt->pc;
+            break;
+        case xop_push_const:
+            xop_push(m, x->form, x->arg[0]);
+            break;
+        case xop_push_seg:
+            hdt->A_REG = x->arg[0] + ram_read(m, x->arg[1]);
+            d = ram_read(m, hdt->A_REG);
+            // Memory.peek(24576), Keyboard.keyPressed() of the Jack OS
+            if (M_ADDR(hdt->A_REG) == HVM_KBD && !d)
+                ++m->kbd_idle;
+            xop_push(m, x->form, d);
+            break;
+        case xop_push_mem:
+            d = ram_read(m, x->arg[0]);
+            if (x->arg[0] == HVM_KBD && !d)
+                ++m->kbd_idle;
+            xop_push(m, x->form, d);
+            break;
+        case xop_pop_seg:
+            *ram_ref(m, x->arg[2]) = x->arg[0] + ram_read(m, x->arg[1]);
+            xop_pop(m);
+            hdt->A_REG = ram_read(m, x->arg[2]);
+            *ram_ref(m, hdt->A_REG) = hdt->D_REG;
+            break;
+        case xop_pop_mem:
+            xop_pop(m);
+            hdt->A_REG = x->arg[0];
+            *ram_ref(m, hdt->A_REG) = hdt->D_REG;
+            break;
+        case xop_binary:
+            xop_pop(m);
+            --hdt->A_REG;
+            xop_alu(m, x->arg[0], DEST_M, 0);
+            break;
+        case xop_unary:
+            hdt->A_REG = ram_read(m, R_SP) - 1;
+            xop_alu(m, x->arg[0], DEST_M, 0);
+            break;
+        case xop_compare:
+            xop_pop(m);
+            --hdt->A_REG;
+            hdt->D_REG = ram_read(m, hdt->A_REG) - hdt->D_REG;
+            hdt->A_REG = ram_read(m, R_SP) - 1;
+            // the false branch is 5 instrs long, the true branch 3
+            if (jump_taken(x->arg[0], hdt->D_REG)) {
+                *ram_ref(m, hdt->A_REG) = -1;
+                n -= 5;
+            } else {
+                *ram_ref(m, hdt->A_REG) = 0;
+                hdt->A_REG = x->arg[2];
+                n -= 3;
+            }
+            pc = x->arg[2];
+            break;
+        case xop_kbd:
+            hdt->A_REG = HVM_KBD;
+            hdt->D_REG = ram_read(m, HVM_KBD);
+            if (!hdt->D_REG)
+                ++m->kbd_idle;
+            break;
+        case xop_if_goto:
+            xop_pop(m);
+            hdt->A_REG = x->arg[0];
+            if (hdt->D_REG != 0)
+                pc = PC_ADDR(hdt->A_REG);
+            break;
+        case xop_hle:
+            if (hle_exec(m, x)) {
+                *xp = NULL;
+                return 1;
+            }
+            // fall back to whatever was fused at the routine entry
+            if (!x->arg[1])
+                return 0;
+            *xp = &m->prog->xops[x->arg[1]];
+            return xop_exec(m, xp);
+        default:
+            break;
+    }
+    hdt->pc = pc;
+    return n;
+}
+
+/*
+ * Jack OS high level emulation
+ *
+ * Math and Memory routines located through the symbol map run natively on
+ * entry, then return through the same effects as the VM translator's
+ * return, with the FRAME and RET temps of the first return sequence
+ * found from the routine entry on. Words above the final SP, i.e. the
+ * routine's locals and working stack, are not reproduced. Error cases
+ * (divide by zero, sqrt of a negative, heap exhausted) decline so the
+ * Hack code runs and reaches Sys.error as usual.
+ *
+ * Memory routines assume the textbook first-fit free list, with its head
+ * in the static named Memory.freeList in the symbol map:
+ *   free segment: seg[0] = length including both header words, seg[1] = next
+ *   block:        block[-1] = length including the header word
+ * Blocks are carved from the end of the first segment that fits, freed
+ * blocks are pushed to the front of the list. Routines whose code does not
+ * go through that head, alloc reading it and deAlloc reading and writing
+ * it, are some other allocator and are left to run as Hack code.
+ */
+static const char *hle_names[hle_count] = {
+        "Math.multiply",
+        "Math.divide",
+        "Math.sqrt",
+        "Memory.alloc",
+        "Memory.deAlloc"
+};
+
+/* Whether the words from pc up to end have '@addr' followed by w */
+static int hle_uses(const hvm_program *prog, int pc, int end, u16 addr, u16 w) {
+    for (; pc + 1 < end; ++pc) {
+        if (prog->rom[pc] == addr && prog->rom[pc + 1] == w)
+            return 1;
+    }
+    return 0;
+}
+
+/* Whether the routine from entry up to its return at end keeps the free list at the heap head */
+static int hle_fingerprint(const hvm_program *prog, int i, int entry, int end) {
+    u16 head = prog->hle_heap;
+
+    if (i != hle_alloc && i != hle_dealloc)
+        return 1;
+    if (!hle_uses(prog, entry, end, head, C_INSTR(COMP_M, DEST_D, 0)))
+        return 0;
+    return i == hle_alloc || hle_uses(prog, entry, end, head, C_INSTR(COMP_D, DEST_M, 0));
+}
+
+/*
+ * Wrap the entry of each routine found in an xop_hle: form is the routine,
+ * arg[0] and arg[2] the FRAME and RET temps, arg[1] the op fused at the
+ * entry, whose length the wrapper takes. Memory routines whose code
+ * fails hle_fingerprint() are not wrapped.
+ */
+static int hle_install(hvm_program *prog) {
+    HVMXop x, ret;
+    u16 addr, inner;
+    int p;
+
+    if (!prog->sym_count)
+        return -1;
+    int has_heap = sym_find(prog, "Memory.freeList", &prog->hle_heap);
+
+    for (int i = 0; i < hle_count && prog->xop_count < ROM_SIZE / 2; ++i) {
+        if (!sym_find(prog, hle_names[i], &addr) || addr >= prog->rom_len)
+            continue;
+        if ((i == hle_alloc || i == hle_dealloc) && !has_heap)
+            continue;
+        for (p = addr; p < prog->rom_len && !match_return(prog, p, &ret); ++p)
+            ;
+        if (p == prog->rom_len || !hle_fingerprint(prog, i, addr, p))
+            continue;
+        inner = prog->xidx[addr];
+        memset(&x, 0, sizeof(x));
+        x.kind = xop_hle;
+        x.len = inner ? prog->xops[inner].len : 1;
+        x.form = (u8) i;
+        x.arg[0] = ret.arg[0];
+        x.arg[1] = inner;
+        x.arg[2] = ret.arg[1];
+        prog->xops[prog->xop_count] = x;
+        prog->xidx[addr] = prog->xop_count++;
+    }
+    return 0;
+}
+
+/* floor(sqrt(x)) for x >= 0 */
+static int16_t hle_isqrt(int16_t x) {
+    int y = 0;
+
+    for (int j = 7; j >= 0; --j) {
+        if ((y + (1 << j)) * (y + (1 << j)) <= x)
+            y += 1 << j;
+    }
+    return y;
+}
+
+static int16_t hle_alloc_block(hvm_machine *m, u16 head, int16_t size) {
+    int16_t seg = ram_read(m, head);
+
+    if (size <= 0)
+        return 0;
+    // bounded walk, a corrupt list is left to the Hack code
+    for (int n = 0; seg && n < RAM_SIZE; ++n, seg = ram_read(m, seg + 1)) {
+        if (ram_read(m, seg) >= size + 3) {
+            *ram_ref(m, seg) -= size + 1;
+            int16_t block = seg + ram_read(m, seg) + 1;
+            *ram_ref(m, block - 1) = size + 1;
+            return block;
+        }
+    }
+    return 0;
+}
+
+static void hle_free_block(hvm_machine *m, u16 head, int16_t block) {
+    int16_t seg = block - 1;
+
+    *ram_ref(m, seg + 1) = ram_read(m, head);
+    *ram_ref(m, head) = seg;
+}
+
+static int hle_exec(hvm_machine *m, const HVMXop *x) {
+    int16_t a0 = ram_read(m, ram_read(m, R_ARG));
+    int16_t a1 = ram_read(m, ram_read(m, R_ARG) + 1);
+    int16_t v = 0;
+
+    switch (x->form) {
+        case hle_multiply:
+            v = a0 * a1;
+            break;
+        case hle_divide:
+            if (!a1)
+                return 0;
+            v = a0 / a1;
+            break;
+        case hle_sqrt:
+            if (a0 < 0)
+                return 0;
+            v = hle_isqrt(a0);
+            break;
+        case hle_alloc:
+            if (!(v = hle_alloc_block(m, m->prog->hle_heap, a0)))
+                return 0;
+            break;
+        case hle_dealloc:
+            hle_free_block(m, m->prog->hle_heap, a0);
+            break;
+        default:
+            return 0;
+    }
+    // leave the result on the stack and return like the translated code would
+    xop_push(m, 1, v);
+    vm_return(m, x->arg[0], x->arg[2]);
+    return 1;
+}
+
+/*
+ * Whether a map entry without a third column names RAM: the predefined
+ * symbols and Jack statics, 'Class.N'
+ */
+static int sym_is_ram(const char *name) {
+    static const char *predefined[] = {"SP", "LCL", "ARG", "THIS", "THAT", "SCREEN", "KBD"};
+    const char *dot = strrchr(name, '.');
+    char *end;
+
+    for (size_t i = 0; i < sizeof(predefined) / sizeof(predefined[0]); ++i) {
+        if (!strcmp(name, predefined[i]))
+            return 1;
+    }
+    if (name[0] == 'R' && isdigit((unsigned char) name[1]) && strtol(name + 1, &end, 10) < 16 && !*end)
+        return 1;
+    if (dot && isdigit((unsigned char) dot[1])) {
+        strtol(dot + 1, &end, 10);
+        return !*end;
+    }
+    return 0;
+}
+
+int hvm_program_load_symbols(hvm_program *prog, const char *path) {
+    char name[sizeof(prog->syms->name)];
+    char kind[8];
+    unsigned addr;
+    char line[256];
+    HVMSym *syms;
+    FILE *fp = fopen(path, "r");
+    int n;
+
+    if (!fp)
+        return HVM_ERR_IO;
+    while (fgets(line, sizeof(line), fp)) {
+        if ((n = sscanf(line, "%127s %u %7s", name, &addr, kind)) < 2 || name[0] == '#')
+            continue;
+        if (prog->sym_count == prog->sym_cap) {
+            syms = realloc(prog->syms, sizeof(HVMSym) * (prog->sym_cap ? prog->sym_cap * 2 : 64));
+            if (!syms) {
+                fclose(fp);
+                return HVM_ERR_NOMEM;
+            }
+            prog->syms = syms;
+            prog->sym_cap = prog->sym_cap ? prog->sym_cap * 2 : 64;
+        }
+        strcpy(prog->syms[prog->sym_count].name, name);
+        prog->syms[prog->sym_count].ram = n == 3 ? !strcmp(kind, "ram") : sym_is_ram(name);
+        prog->syms[prog->sym_count++].addr = addr;
+    }
+    fclose(fp);
+    return HVM_OK;
+}
+
+int hvm_load_symbols(hvm_machine *m, const char *path) {
+    hvm_program *prog = prog_private(m);
+
+    return prog ? hvm_program_load_symbols(prog, path) : HVM_ERR_NOMEM;
+}
+
+const char *hvm_symbol(const hvm_machine *m, uint16_t addr) {
+    for (int i = 0; i < m->prog->sym_count; ++i) {
+        if (m->prog->syms[i].addr == addr)
+            return m->prog->syms[i].name;
+    }
+    return NULL;
+}
+
+const char *hvm_label(const hvm_machine *m, uint16_t addr) {
+    for (int i = 0; i < m->prog->sym_count; ++i) {
+        if (m->prog->syms[i].addr == addr && !m->prog->syms[i].ram)
+            return m->prog->syms[i].name;
+    }
+    return NULL;
+}
+
+static int sym_find(const hvm_program *prog, const char *name, u16 *addr) {
+    for (int i = 0; i < prog->sym_count; ++i) {
+        if (!strcmp(prog->syms[i].name, name)) {
+            *addr = prog->syms[i].addr;
+            return 1;
+        }
+    }
+    return 0;
+}
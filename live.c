@@ -0,0 +1,93 @@
+/*
+ * live.c
+ *
+ * Shared memory view of a running machine for monitors, see live.h. The
+ * VM writes RAM in place, registers and counts are copied in between run
+ * slices so the interpreter loop does not change.
+ */
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "live.h"
+
+struct live {
+    struct hvm_live *head;
+    char *name;
+};
+
+live *live_open(const char *name, hvm_machine *m) {
+    live *l = calloc(1, sizeof(live));
+    int fd = -1;
+    void *p = MAP_FAILED;
+
+    if (!l || !(l->name = strdup(name)))
+        goto fail;
+    // never take over an object another process may be publishing in
+    if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) < 0)
+        goto fail;
+    if (ftruncate(fd, LIVE_SIZE) || (p = mmap(NULL, LIVE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        shm_unlink(name);
+        goto fail;
+    }
+    close(fd);
+
+    l->head = p;
+    l->head->magic = LIVE_MAGIC;
+    l->head->version = LIVE_VERSION;
+    l->head->pid = (uint32_t) getpid();
+    hvm_ram_map(m, (int16_t *) ((char *) p + LIVE_RAM));
+    live_update(l, m, 0);
+    return l;
+
+fail:
+    if (fd >= 0)
+        close(fd);
+    if (l)
+        free(l->name);
+    free(l);
+    return NULL;
+}
+
+void live_update(live *l, const hvm_machine *m, long instrs) {
+    struct hvm_live *h = l->head;
+    _Atomic uint32_t *seq = (_Atomic uint32_t *) &h->seq;
+    uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    struct hvm_stats st;
+    struct timespec now;
+
+    hvm_get_stats(m, &st);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // odd while the header is being written
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    h->a = hvm_get_reg(m, HVM_REG_A);
+    h->d = hvm_get_reg(m, HVM_REG_D);
+    h->pc = hvm_get_reg(m, HVM_REG_PC);
+    h->halted = (uint32_t) hvm_halted(m);
+    h->updated_ns = (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+    h->instrs = (uint64_t) instrs;
+    h->kbd_idle = hvm_kbd_idle(m);
+    h->has_stats = st.instrs != 0;
+    h->stats.a_instrs = st.a_instrs;
+    h->stats.c_instrs = st.c_instrs;
+    h->stats.jumps_taken = st.jumps_taken;
+    h->stats.jumps_not_taken = st.jumps_not_taken;
+    h->stats.ram_reads = st.ram_reads;
+    h->stats.ram_writes = st.ram_writes;
+    atomic_store_explicit(seq, s + 2, memory_order_release);
+}
+
+void live_close(live *l) {
+    if (!l)
+        return;
+    munmap(l->head, LIVE_SIZE);
+    shm_unlink(l->name);
+    free(l->name);
+    free(l);
+}
@@ -0,0 +1,58 @@
+/*
+ * live.h
+ *
+ * Machine state published in a POSIX shared memory object, hvm --live.
+ * Monitors shm_open() it read only and map LIVE_SIZE bytes: the header
+ * below, then RAM from LIVE_RAM on, HVM_RAM_SIZE 16 bit words the machine
+ * runs on. RAM is live, the header is rewritten at block entries, every
+ * so many instrs, under the seqlock seq: read seq, wait while it is odd,
+ * copy the header, and read seq again after an acquire fence. The copy
+ * holds if both reads agree.
+ */
+
+#ifndef HVM_LIVE_H
+#define HVM_LIVE_H
+
+#include <stdint.h>
+#include "hvm.h"
+
+#define LIVE_MAGIC 0x4c4d5648u  // 'HVML'
+#define LIVE_VERSION 1
+#define LIVE_RAM 4096
+#define LIVE_SIZE (LIVE_RAM + HVM_RAM_SIZE * 2)
+
+struct hvm_live {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    uint32_t pid;
+    int32_t a, d, pc;
+    uint32_t halted;
+    uint64_t updated_ns;        // CLOCK_MONOTONIC
+    uint64_t instrs;
+    uint64_t kbd_idle;
+    uint32_t has_stats;         // the rest is kept with --stats only
+    uint32_t reserved;
+    struct {
+        uint64_t a_instrs, c_instrs;
+        uint64_t jumps_taken, jumps_not_taken;
+        uint64_t ram_reads, ram_writes;
+    } stats;
+};
+
+typedef struct live live;
+
+/*
+ * Create the object name, as shm_open() takes it ("/hvm-1" say), readable
+ * by the owner only, and move m's RAM into it. Returns NULL, errno set, if
+ * it could not be created or mapped, EEXIST if it exists already.
+ */
+live *live_open(const char *name, hvm_machine *m);
+
+/* Publish m's registers and counts, instrs being those run so far */
+void live_update(live *l, const hvm_machine *m, long instrs);
+
+/* Unmap and unlink the object, m must be destroyed first */
+void live_close(live *l);
+
+#endif //HVM_LIVE_H
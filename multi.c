@@ -0,0 +1,150 @@
+/*
+ * multi.c
+ *
+ * Multi-core Hack, see multi.h for the mailbox layout.
+ *
+ * Rings are single producer, single consumer: only the sending CPU's
+ * thread moves tail and only the receiving CPU's thread moves head, so a
+ * word crosses threads with one release store and one acquire load.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "hvm.h"
+#include "multi.h"
+
+#define RING_SIZE 256u
+
+typedef struct {
+    _Alignas(64) atomic_uint head;
+    _Alignas(64) atomic_uint tail;
+    int16_t buf[RING_SIZE];
+} MultiRing;
+
+typedef struct {
+    hvm_machine *m;
+    int id;
+    int n;
+    long quantum;
+    MultiRing *rings;   // n x n, rings[from * n + to]
+    atomic_int *abort;  // set when not all CPUs could start
+} MultiCpu;
+
+static int ring_push(MultiRing *r, int16_t v) {
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (t - atomic_load_explicit(&r->head, memory_order_acquire) == RING_SIZE)
+        return 0;
+    r->buf[t & (RING_SIZE - 1)] = v;
+    atomic_store_explicit(&r->tail, t + 1, memory_order_release);
+    return 1;
+}
+
+static int ring_pop(MultiRing *r, int16_t *v) {
+    unsigned h = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    if (h == atomic_load_explicit(&r->tail, memory_order_acquire))
+        return 0;
+    *v = r->buf[h & (RING_SIZE - 1)];
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+    return 1;
+}
+
+/* Move full TX slots into the rings and refill empty RX slots from them */
+static void mbox_sync(const MultiCpu *c) {
+    int16_t v;
+
+    for (int j = 0; j < c->n; ++j) {
+        uint16_t peer = MBOX_PEER(j);
+
+        if (j == c->id)
+            continue;
+        if (hvm_read(c->m, peer + 1) && ring_push(&c->rings[c->id * c->n + j], hvm_read(c->m, peer)))
+            hvm_write(c->m, peer + 1, 0);
+        if (!hvm_read(c->m, peer + 3) && ring_pop(&c->rings[j * c->n + c->id], &v)) {
+            hvm_write(c->m, peer + 2, v);
+            hvm_write(c->m, peer + 3, 1);
+        }
+    }
+}
+
+static void *multi_cpu(void *arg) {
+    const MultiCpu *c = arg;
+
+    while (!hvm_halted(c->m)) {
+        // a CPU waiting on a peer that never started would never halt
+        if (atomic_load_explicit(c->abort, memory_order_relaxed))
+            return NULL;
+        hvm_run_slice(c->m, c->quantum);
+        mbox_sync(c);
+    }
+    // the last words sent must reach the rings
+    mbox_sync(c);
+    return NULL;
+}
+
+int multi_run(char **roms, int n, unsigned flags, const char *symbols, long quantum,
+              void (*snapshot)(const hvm_machine *)) {
+    MultiCpu cpus[MULTI_MAX_CPUS];
+    pthread_t threads[MULTI_MAX_CPUS];
+    MultiRing *rings;
+    atomic_int abort;
+    int err, started = 0, running = 0;
+
+    if (n < 1 || n > MULTI_MAX_CPUS) {
+        fprintf(stderr, "error: %d CPUs, 1 to %d supported\n", n, MULTI_MAX_CPUS);
+        return -1;
+    }
+    if (!(rings = aligned_alloc(_Alignof(MultiRing), sizeof(MultiRing) * n * n))) {
+        fprintf(stderr, "error: %s\n", hvm_strerror(HVM_ERR_NOMEM));
+        return -1;
+    }
+    for (int i = 0; i < n * n; ++i) {
+        atomic_init(&rings[i].head, 0);
+        atomic_init(&rings[i].tail, 0);
+    }
+    atomic_init(&abort, 0);
+
+    for (int i = 0; i < n; ++i) {
+        cpus[i] = (MultiCpu) {.id=i, .n=n, .quantum=quantum, .rings=rings, .abort=&abort};
+        if (!(cpus[i].m = hvm_create(flags))) {
+            fprintf(stderr, "error: [%s] %s\n", roms[i], hvm_strerror(HVM_ERR_NOMEM));
+            goto out;
+        }
+        if ((symbols && (err = hvm_load_symbols(cpus[i].m, symbols))) ||
+            (err = hvm_load_file(cpus[i].m, roms[i]))) {
+            fprintf(stderr, "error: [%s] %s\n", roms[i], hvm_strerror(err));
+            hvm_destroy(cpus[i].m);
+            goto out;
+        }
+        hvm_write(cpus[i].m, MBOX_ID, i);
+        hvm_write(cpus[i].m, MBOX_CPUS, n);
+        ++started;
+    }
+
+    for (running = 0; running < n; ++running) {
+        if (pthread_create(&threads[running], NULL, multi_cpu, &cpus[running])) {
+            fprintf(stderr, "error: [%s] unable to start thread\n", roms[running]);
+            // stop the CPUs already started, they may wait on this one
+            atomic_store_explicit(&abort, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    for (int i = 0; i < running; ++i)
+        pthread_join(threads[i], NULL);
+    if (running < n)
+        goto out;
+    for (int i = 0; i < n && snapshot; ++i) {
+        printf("CPU %d [%s]\n", i, roms[i]);
+        snapshot(cpus[i].m);
+    }
+
+out:
+    for (int i = 0; i < started; ++i)
+        hvm_destroy(cpus[i].m);
+    free(rings);
+    return started == n && running == n ? 0 : -1;
+}
@@ -0,0 +1,36 @@
+/*
+ * multi.h
+ */
+
+#ifndef HVM_MULTI_H
+#define HVM_MULTI_H
+
+#include "hvm.h"
+
+/*
+ * Multi-core Hack, every CPU runs its own ROM on its own host thread and
+ * talks to the others through a mailbox page in RAM:
+ *
+ *   MBOX_ID            this CPU's number, 0 based
+ *   MBOX_CPUS          number of CPUs
+ *   MBOX_PEER(j) + 0   TX, word to send to CPU j
+ *   MBOX_PEER(j) + 1   TX full, set to 1 after writing TX, cleared once sent
+ *   MBOX_PEER(j) + 2   RX, word received from CPU j
+ *   MBOX_PEER(j) + 3   RX full, 1 while RX holds a word, clear it after reading
+ *
+ * The host moves words between the mailbox page and lock-free rings, one
+ * per ordered pair of CPUs, each time a CPU reaches a block entry after
+ * quantum instrs. Between those points a CPU runs undisturbed.
+ */
+#define MBOX_BASE 0x6100
+#define MBOX_ID MBOX_BASE
+#define MBOX_CPUS (MBOX_BASE + 1)
+#define MBOX_PEER(j) (MBOX_BASE + 16 + 4 * (j))
+
+#define MULTI_MAX_CPUS 16
+
+/* Run one CPU per ROM until all halt, snapshot prints each one's memory */
+int multi_run(char **roms, int n, unsigned flags, const char *symbols, long quantum,
+              void (*snapshot)(const hvm_machine *));
+
+#endif //HVM_MULTI_H
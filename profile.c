@@ -0,0 +1,90 @@
+/*
+ * profile.c
+ *
+ * Per-PC hot-spot report. The VM counts block entries only, a block runs
+ * straight from its entry through the next jump, so every word of it ran
+ * as often as it was entered. Fused compares count the entries their
+ * instrs would, and a Jack OS routine run natively is credited as if its
+ * first block ran.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "disasm.h"
+#include "hvm.h"
+#include "profile.h"
+
+static const uint64_t *sort_counts;
+
+/* Hottest first, then by address */
+static int by_heat(const void *a, const void *b) {
+    uint16_t x = *(const uint16_t *) a, y = *(const uint16_t *) b;
+
+    if (sort_counts[x] != sort_counts[y])
+        return sort_counts[x] < sort_counts[y] ? 1 : -1;
+    return x - y;
+}
+
+int profile_write(const hvm_machine *m, unsigned flags, const uint64_t *entries, const char *path) {
+    int len = hvm_rom_len(m);
+    int extended = (flags & HVM_EXTENDED) != 0;
+    uint64_t *counts = calloc(HVM_ROM_SIZE, sizeof(uint64_t));
+    uint16_t *order = malloc(sizeof(uint16_t) * HVM_ROM_SIZE);
+    const char **label = calloc(HVM_ROM_SIZE, sizeof(char *));
+    uint16_t *label_at = calloc(HVM_ROM_SIZE, sizeof(uint16_t));
+    uint64_t total = 0, cum = 0;
+    int n = 0;
+    char text[32];
+    FILE *fp;
+
+    if (!counts || !order || !label || !label_at || !(fp = fopen(path, "w"))) {
+        free(counts);
+        free(order);
+        free(label);
+        free(label_at);
+        return -1;
+    }
+
+    for (int e = 0; e < len; ++e) {
+        for (int pc = e; entries[e] && pc < len; ++pc) {
+            counts[pc] += entries[e];
+            if (disasm_is_jump(hvm_rom(m, pc), extended))
+                break;
+        }
+    }
+    // nearest label at or before each word
+    for (int pc = 0; pc < len; ++pc) {
+        const char *name = hvm_label(m, pc);
+        label[pc] = name ? name : pc ? label[pc - 1] : NULL;
+        label_at[pc] = name ? pc : pc ? label_at[pc - 1] : 0;
+        total += counts[pc];
+        if (counts[pc])
+            order[n++] = pc;
+    }
+    sort_counts = counts;
+    qsort(order, n, sizeof(uint16_t), by_heat);
+
+    fprintf(fp, "# %llu instrs in %d words\n", (unsigned long long) total, n);
+    fprintf(fp, "#%15s %7s %7s %6s  %-16s %s\n", "count", "%", "cum%", "addr", "instr", "label");
+    for (int i = 0; i < n; ++i) {
+        uint16_t pc = order[i];
+
+        cum += counts[pc];
+        disasm(hvm_rom(m, pc), extended, text, sizeof(text));
+        fprintf(fp, "%16llu %6.2f%% %6.2f%% %6u  %-16s ", (unsigned long long) counts[pc],
+                100.0 * counts[pc] / total, 100.0 * cum / total, pc, text);
+        if (label[pc] && label_at[pc] == pc)
+            fprintf(fp, "%s\n", label[pc]);
+        else if (label[pc])
+            fprintf(fp, "%s+%d\n", label[pc], pc - label_at[pc]);
+        else
+            fputc('\n', fp);
+    }
+
+    fclose(fp);
+    free(counts);
+    free(order);
+    free(label);
+    free(label_at);
+    return 0;
+}
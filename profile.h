@@ -0,0 +1,20 @@
+/*
+ * profile.h
+ */
+
+#ifndef HVM_PROFILE_H
+#define HVM_PROFILE_H
+
+#include <stdint.h>
+#include "hvm.h"
+
+/*
+ * Write the hot-spot report for m, created with flags, to path, entries
+ * being the block entry counts collected with hvm_set_profile(). Every executed ROM word is
+ * listed with its count, share and disassembly, hottest first, labelled
+ * from the symbol map when there is one. Returns 0, -1 if path could not
+ * be written.
+ */
+int profile_write(const hvm_machine *m, unsigned flags, const uint64_t *entries, const char *path);
+
+#endif //HVM_PROFILE_H
@@ -0,0 +1,308 @@
+/*
+ * pyhvm.c
+ *
+ * CPython extension, the hvm module. A Machine pins its RAM so the ram
+ * attribute can hand out the block itself through the buffer protocol,
+ * numpy.asarray(m.ram) or m.ram[0x4000:0x6000] copy nothing. rom views
+ * hold a reference to the program, a later load gives the machine a new
+ * one and leaves them intact. run() releases the GIL.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "hvm.h"
+
+typedef struct {
+    PyObject_HEAD
+    hvm_machine *m;
+    int16_t *ram;
+    int busy;       // run() in progress with the GIL released
+} Machine;
+
+/* Buffer over RAM or ROM words, keeps what backs it alive */
+typedef struct {
+    PyObject_HEAD
+    PyObject *owner;
+    hvm_program *prog;
+    void *words;
+    Py_ssize_t len;
+    int readonly;
+} Words;
+
+static PyTypeObject MachineType;
+static PyTypeObject WordsType;
+
+static int machine_check(Machine *self) {
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "machine is running");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *machine_error(int err, const char *path) {
+    if (err == HVM_ERR_NOMEM)
+        return PyErr_NoMemory();
+    if (err == HVM_ERR_IO)
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    PyErr_Format(PyExc_ValueError, "[%s] %s", path ? path : "buffer", hvm_strerror(err));
+    return NULL;
+}
+
+static PyObject *machine_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"rom", "flags", "symbols", NULL};
+    const char *rom = NULL, *symbols = NULL;
+    unsigned flags = 0;
+    Machine *self;
+    int err;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|zIz", kwlist, &rom, &flags, &symbols))
+        return NULL;
+    if (!(self = (Machine *) type->tp_alloc(type, 0)))
+        return NULL;
+    if (!(self->m = hvm_create(flags)) || !(self->ram = hvm_ram_pin(self->m))) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    if (symbols && (err = hvm_load_symbols(self->m, symbols))) {
+        Py_DECREF(self);
+        return machine_error(err, symbols);
+    }
+    if (rom && (err = hvm_load_file(self->m, rom))) {
+        Py_DECREF(self);
+        return machine_error(err, rom);
+    }
+    return (PyObject *) self;
+}
+
+static void machine_dealloc(Machine *self) {
+    hvm_destroy(self->m);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *machine_load(Machine *self, PyObject *arg) {
+    int err;
+
+    if (machine_check(self))
+        return NULL;
+    if (PyUnicode_Check(arg)) {
+        const char *path = PyUnicode_AsUTF8(arg);
+        if (!path)
+            return NULL;
+        if ((err = hvm_load_file(self->m, path)))
+            return machine_error(err, path);
+    } else {
+        Py_buffer view;
+        if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE))
+            return NULL;
+        err = hvm_load_buffer(self->m, view.buf, view.len);
+        PyBuffer_Release(&view);
+        if (err)
+            return machine_error(err, NULL);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *machine_load_symbols(Machine *self, PyObject *args) {
+    const char *path;
+    int err;
+
+    if (!PyArg_ParseTuple(args, "s", &path) || machine_check(self))
+        return NULL;
+    if ((err = hvm_load_symbols(self->m, path)))
+        return machine_error(err, path);
+    Py_RETURN_NONE;
+}
+
+static PyObject *machine_reset(Machine *self, PyObject *unused) {
+    (void) unused;
+    if (machine_check(self))
+        return NULL;
+    hvm_reset(self->m);
+    Py_RETURN_NONE;
+}
+
+static PyObject *machine_run(Machine *self, PyObject *args) {
+    long steps = -1, n;
+
+    if (!PyArg_ParseTuple(args, "|l", &steps) || machine_check(self))
+        return NULL;
+    self->busy = 1;
+    Py_BEGIN_ALLOW_THREADS
+    n = hvm_run(self->m, steps);
+    Py_END_ALLOW_THREADS
+    self->busy = 0;
+    return PyLong_FromLong(n);
+}
+
+static PyObject *machine_step(Machine *self, PyObject *unused) {
+    (void) unused;
+    if (machine_check(self))
+        return NULL;
+    return PyBool_FromLong(hvm_step(self->m));
+}
+
+static PyObject *words_new(PyObject *owner, hvm_program *prog, void *words, Py_ssize_t len, int readonly) {
+    Words *w = PyObject_New(Words, &WordsType);
+
+    if (!w)
+        return NULL;
+    Py_XINCREF(owner);
+    w->owner = owner;
+    w->prog = prog ? hvm_program_retain(prog) : NULL;
+    w->words = words;
+    w->len = len;
+    w->readonly = readonly;
+    return (PyObject *) w;
+}
+
+/* memoryview of the pinned RAM, int16 words */
+static PyObject *machine_get_ram(Machine *self, void *closure) {
+    PyObject *w = words_new((PyObject *) self, NULL, self->ram, HVM_RAM_SIZE, 0);
+    PyObject *view;
+
+    (void) closure;
+    if (!w)
+        return NULL;
+    view = PyMemoryView_FromObject(w);
+    Py_DECREF(w);
+    return view;
+}
+
+/* Read only memoryview of the program's ROM, uint16 words */
+static PyObject *machine_get_rom(Machine *self, void *closure) {
+    hvm_program *prog = hvm_get_program(self->m);
+    PyObject *w = words_new(NULL, prog, (void *) hvm_program_rom(prog), hvm_rom_len(self->m), 1);
+    PyObject *view;
+
+    (void) closure;
+    if (!w)
+        return NULL;
+    view = PyMemoryView_FromObject(w);
+    Py_DECREF(w);
+    return view;
+}
+
+static PyObject *machine_get_reg(Machine *self, void *closure) {
+    return PyLong_FromLong(hvm_get_reg(self->m, (enum hvm_reg) (intptr_t) closure));
+}
+
+static int machine_set_reg(Machine *self, PyObject *value, void *closure) {
+    long v;
+
+    if (!value) {
+        PyErr_SetString(PyExc_AttributeError, "registers can not be deleted");
+        return -1;
+    }
+    if ((v = PyLong_AsLong(value)) == -1 && PyErr_Occurred())
+        return -1;
+    if (machine_check(self))
+        return -1;
+    hvm_set_reg(self->m, (enum hvm_reg) (intptr_t) closure, (int) v);
+    return 0;
+}
+
+static PyObject *machine_get_halted(Machine *self, void *closure) {
+    (void) closure;
+    return PyBool_FromLong(hvm_halted(self->m));
+}
+
+static PyMethodDef machine_methods[] = {
+        {"load",         (PyCFunction) machine_load,         METH_O,       "load(path_or_bytes), load a .hex image and reset"},
+        {"load_symbols", (PyCFunction) machine_load_symbols, METH_VARARGS, "load_symbols(path), symbol map for OS emulation"},
+        {"reset",        (PyCFunction) machine_reset,        METH_NOARGS,  "clear RAM and registers"},
+        {"run",          (PyCFunction) machine_run,          METH_VARARGS, "run(steps=-1), run without the GIL, returns instrs executed"},
+        {"step",         (PyCFunction) machine_step,         METH_NOARGS,  "execute one instr, False if halted"},
+        {NULL}
+};
+
+static PyGetSetDef machine_getset[] = {
+        {"ram",    (getter) machine_get_ram,    NULL,                     "RAM as a writable int16 memoryview", NULL},
+        {"rom",    (getter) machine_get_rom,    NULL,                     "loaded ROM words as a read only uint16 memoryview", NULL},
+        {"a",      (getter) machine_get_reg,    (setter) machine_set_reg, "A register", (void *) HVM_REG_A},
+        {"d",      (getter) machine_get_reg,    (setter) machine_set_reg, "D register", (void *) HVM_REG_D},
+        {"pc",     (getter) machine_get_reg,    (setter) machine_set_reg, "program counter", (void *) HVM_REG_PC},
+        {"halted", (getter) machine_get_halted, NULL,                     "True once the machine halted", NULL},
+        {NULL}
+};
+
+static PyTypeObject MachineType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "hvm.Machine",
+        .tp_doc = "Machine(rom=None, flags=0, symbols=None), a Hack machine",
+        .tp_basicsize = sizeof(Machine),
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_new = machine_new,
+        .tp_dealloc = (destructor) machine_dealloc,
+        .tp_methods = machine_methods,
+        .tp_getset = machine_getset,
+};
+
+static int words_getbuffer(Words *self, Py_buffer *view, int flags) {
+    if (self->readonly && (flags & PyBUF_WRITABLE)) {
+        PyErr_SetString(PyExc_BufferError, "ROM is read only");
+        return -1;
+    }
+    view->obj = (PyObject *) self;
+    Py_INCREF(self);
+    view->buf = self->words;
+    view->len = self->len * 2;
+    view->itemsize = 2;
+    view->readonly = self->readonly;
+    view->ndim = 1;
+    view->format = (flags & PyBUF_FORMAT) ? (self->readonly ? "H" : "h") : NULL;
+    view->shape = (flags & PyBUF_ND) ? &self->len : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &view->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static void words_dealloc(Words *self) {
+    Py_XDECREF(self->owner);
+    hvm_program_release(self->prog);
+    PyObject_Free(self);
+}
+
+static PyBufferProcs words_as_buffer = {
+        .bf_getbuffer = (getbufferproc) words_getbuffer,
+};
+
+static PyTypeObject WordsType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "hvm._Words",
+        .tp_basicsize = sizeof(Words),
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_dealloc = (destructor) words_dealloc,
+        .tp_as_buffer = &words_as_buffer,
+};
+
+static struct PyModuleDef hvm_module = {
+        PyModuleDef_HEAD_INIT,
+        .m_name = "hvm",
+        .m_doc = "Hack virtual machine",
+        .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_hvm(void) {
+    PyObject *mod;
+
+    if (PyType_Ready(&MachineType) < 0 || PyType_Ready(&WordsType) < 0)
+        return NULL;
+    if (!(mod = PyModule_Create(&hvm_module)))
+        return NULL;
+    Py_INCREF(&MachineType);
+    if (PyModule_AddObject(mod, "Machine", (PyObject *) &MachineType) < 0) {
+        Py_DECREF(&MachineType);
+        Py_DECREF(mod);
+        return NULL;
+    }
+    PyModule_AddIntConstant(mod, "NO_FUSE", HVM_NO_FUSE);
+    PyModule_AddIntConstant(mod, "EMULATE_OS", HVM_EMULATE_OS);
+    PyModule_AddIntConstant(mod, "EXTENDED", HVM_EXTENDED);
+    PyModule_AddIntConstant(mod, "RAM_SIZE", HVM_RAM_SIZE);
+    PyModule_AddIntConstant(mod, "SCREEN", HVM_SCREEN);
+    PyModule_AddIntConstant(mod, "SCREEN_SIZE", HVM_SCREEN_SIZE);
+    PyModule_AddIntConstant(mod, "KBD", HVM_KBD);
+    return mod;
+}
@@ -0,0 +1,230 @@
+/*
+ * sched.c
+ *
+ * Cooperative scheduler, many machines time sliced on one thread.
+ *
+ * Stride scheduling: every runnable machine has a pass, the virtual time
+ * it has used so far. The machine with the lowest pass runs next, for one
+ * hvm_run_slice(), and its pass then grows by the instrs it executed over
+ * its weight. Runnable machines sit in a binary heap ordered by pass,
+ * parked ones are only in the table.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "hvm.h"
+
+/* Pass units per instr at weight 1 */
+#define STRIDE 1024u
+
+#define MAX_WEIGHT 1024
+
+/* Empty keyboard reads in one turn for a machine to count as polling */
+#define KBD_POLLS 8
+
+/* RAM a machine waiting for a key leaves alone: statics, heap and screen */
+#define STATIC_FIRST 16
+#define STATIC_LAST 255
+#define HEAP_FIRST 2048
+
+typedef struct {
+    hvm_machine *m;
+    uint64_t pass;
+    int weight;
+    int state;
+    int heap;   // position in the heap, -1 if parked
+    int polled; // the last turn polled an empty keyboard, digest is RAM after it
+    uint64_t digest;
+} HVMTask;
+
+struct hvm_sched {
+    long quantum;
+    HVMTask *tasks;
+    int count;
+    int cap;
+    int *heap;
+    int runnable;
+};
+
+static void heap_push(hvm_sched *, int id);
+static void heap_pop(hvm_sched *);
+static void heap_down(hvm_sched *, int pos);
+static void heap_up(hvm_sched *, int pos);
+
+
+hvm_sched *hvm_sched_create(long quantum) {
+    hvm_sched *s = calloc(1, sizeof(hvm_sched));
+
+    if (!s)
+        return NULL;
+    s->quantum = quantum > 0 ? quantum : 1;
+    return s;
+}
+
+void hvm_sched_destroy(hvm_sched *s) {
+    if (!s)
+        return;
+    free(s->tasks);
+    free(s->heap);
+    free(s);
+}
+
+static int clamp_weight(int weight) {
+    return weight < 1 ? 1 : weight > MAX_WEIGHT ? MAX_WEIGHT : weight;
+}
+
+int hvm_sched_add(hvm_sched *s, hvm_machine *m, int weight) {
+    HVMTask *t;
+
+    if (s->count == s->cap) {
+        int cap = s->cap ? s->cap * 2 : 64;
+        HVMTask *tasks = realloc(s->tasks, sizeof(HVMTask) * cap);
+        int *heap = tasks ? realloc(s->heap, sizeof(int) * cap) : NULL;
+
+        if (tasks)
+            s->tasks = tasks;
+        if (!heap)
+            return HVM_ERR_NOMEM;
+        s->heap = heap;
+        s->cap = cap;
+    }
+    t = &s->tasks[s->count];
+    t->m = m;
+    t->weight = clamp_weight(weight);
+    // join at the current virtual time, not ahead of the others
+    t->pass = s->runnable ? s->tasks[s->heap[0]].pass : 0;
+    t->heap = -1;
+    t->polled = 0;
+    t->state = hvm_halted(m) ? HVM_SCHED_HALTED : HVM_SCHED_RUNNABLE;
+    if (t->state == HVM_SCHED_RUNNABLE)
+        heap_push(s, s->count);
+    return s->count++;
+}
+
+void hvm_sched_set_weight(hvm_sched *s, int id, int weight) {
+    if (id >= 0 && id < s->count)
+        s->tasks[id].weight = clamp_weight(weight);
+}
+
+/*
+ * Whether a machine waits for a key: two turns in a row polled an empty
+ * keyboard and left RAM outside the registers and the stack as it was. A
+ * machine that polls once a frame while it draws or counts keeps running.
+ */
+static int kbd_wait(HVMTask *t, unsigned long polls) {
+    uint64_t digest;
+    int same;
+
+    if (polls < KBD_POLLS || hvm_read(t->m, HVM_KBD)) {
+        t->polled = 0;
+        return 0;
+    }
+    digest = hvm_ram_digest(t->m, STATIC_FIRST, STATIC_LAST) + hvm_ram_digest(t->m, HEAP_FIRST, HVM_KBD - 1);
+    same = t->polled && digest == t->digest;
+    t->polled = 1;
+    t->digest = digest;
+    return same;
+}
+
+long hvm_sched_run(hvm_sched *s, long max_steps) {
+    long total = 0;
+
+    while (s->runnable && (max_steps < 0 || total < max_steps)) {
+        int id = s->heap[0];
+        HVMTask *t = &s->tasks[id];
+        unsigned long idle = hvm_kbd_idle(t->m);
+        long n = hvm_run_slice(t->m, s->quantum);
+
+        total += n;
+        // a turn always costs something, or a machine that runs nothing would never yield
+        t->pass += (uint64_t) (n ? n : 1) * (STRIDE / t->weight);
+
+        if (hvm_halted(t->m)) {
+            t->state = HVM_SCHED_HALTED;
+            heap_pop(s);
+        } else if (kbd_wait(t, hvm_kbd_idle(t->m) - idle)) {
+            t->state = HVM_SCHED_KBD_WAIT;
+            heap_pop(s);
+        } else {
+            heap_down(s, 0);
+        }
+    }
+    return total;
+}
+
+void hvm_sched_key(hvm_sched *s, int id, int16_t key) {
+    HVMTask *t;
+
+    if (id < 0 || id >= s->count)
+        return;
+    t = &s->tasks[id];
+    hvm_write(t->m, HVM_KBD, key);
+    if (t->state == HVM_SCHED_KBD_WAIT && key) {
+        t->state = HVM_SCHED_RUNNABLE;
+        t->polled = 0;
+        // no catching up on the turns spent parked
+        if (s->runnable && t->pass < s->tasks[s->heap[0]].pass)
+            t->pass = s->tasks[s->heap[0]].pass;
+        heap_push(s, id);
+    }
+}
+
+enum hvm_sched_state hvm_sched_state(const hvm_sched *s, int id) {
+    return id >= 0 && id < s->count ? s->tasks[id].state : HVM_SCHED_HALTED;
+}
+
+int hvm_sched_runnable(const hvm_sched *s) {
+    return s->runnable;
+}
+
+static void heap_swap(hvm_sched *s, int i, int j) {
+    int id = s->heap[i];
+
+    s->heap[i] = s->heap[j];
+    s->heap[j] = id;
+    s->tasks[s->heap[i]].heap = i;
+    s->tasks[s->heap[j]].heap = j;
+}
+
+static int heap_less(const hvm_sched *s, int i, int j) {
+    return s->tasks[s->heap[i]].pass < s->tasks[s->heap[j]].pass;
+}
+
+static void heap_push(hvm_sched *s, int id) {
+    s->heap[s->runnable] = id;
+    s->tasks[id].heap = s->runnable;
+    heap_up(s, s->runnable++);
+}
+
+/* Drop the top task, it is parked */
+static void heap_pop(hvm_sched *s) {
+    s->tasks[s->heap[0]].heap = -1;
+    if (--s->runnable) {
+        s->heap[0] = s->heap[s->runnable];
+        s->tasks[s->heap[0]].heap = 0;
+        heap_down(s, 0);
+    }
+}
+
+static void heap_down(hvm_sched *s, int pos) {
+    for (;;) {
+        int least = pos;
+        int l = 2 * pos + 1;
+
+        if (l < s->runnable && heap_less(s, l, least))
+            least = l;
+        if (l + 1 < s->runnable && heap_less(s, l + 1, least))
+            least = l + 1;
+        if (least == pos)
+            return;
+        heap_swap(s, pos, least);
+        pos = least;
+    }
+}
+
+static void heap_up(hvm_sched *s, int pos) {
+    while (pos && heap_less(s, pos, (pos - 1) / 2)) {
+        heap_swap(s, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
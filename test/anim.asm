@@ -0,0 +1,14 @@
+// Counts frames in RAM[100], polling the keyboard once a frame, until a
+// key is pressed; the key goes to RAM[101]. See sched.c.
+(FRAME)
+@KBD
+D=M
+@DONE
+D;JNE
+@100
+M=M+1
+@FRAME
+0;JMP
+(DONE)
+@101
+M=D
@@ -0,0 +1,962 @@
+// Translated from the VM code below, see equiv.c. Pushes use the
+// @SP A=M M=D @SP M=M+1 form, segment addresses @i D=A @seg first.
+//
+// function Sys.init 0
+// push constant 12
+// call Main.fib 1
+// pop static 0
+// push constant 7
+// push constant 5
+// call Main.mul 2
+// pop static 1
+// push constant 3
+// neg
+// push constant 9
+// lt
+// pop static 2
+// push constant 9
+// push constant 3
+// gt
+// pop static 3
+// push constant 4
+// push constant 4
+// eq
+// pop static 4
+// push constant 4
+// push constant 5
+// eq
+// pop static 5
+// push constant 0
+// return
+// function Main.fib 0
+// push argument 0
+// push constant 2
+// lt
+// if-goto BASE
+// push argument 0
+// push constant 1
+// sub
+// call Main.fib 1
+// push argument 0
+// push constant 2
+// sub
+// call Main.fib 1
+// add
+// return
+// label BASE
+// push argument 0
+// return
+// function Main.mul 2
+// push constant 0
+// pop local 0
+// push argument 1
+// pop local 1
+// label LOOP
+// push local 1
+// push constant 0
+// eq
+// if-goto DONE
+// push local 0
+// push argument 0
+// add
+// pop local 0
+// push local 1
+// push constant 1
+// sub
+// pop local 1
+// goto LOOP
+// label DONE
+// push local 0
+// return
+
+@256
+D=A
+@SP
+M=D
+@RET1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@0
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Sys.init
+0;JMP
+(RET1)
+@HALT
+0;JMP
+(Sys.init)
+@12
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET2
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Main.fib
+0;JMP
+(RET2)
+@SP
+AM=M-1
+D=M
+@calls.0
+M=D
+@7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@5
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET3
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Main.mul
+0;JMP
+(RET3)
+@SP
+AM=M-1
+D=M
+@calls.1
+M=D
+@3
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@9
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT4
+D;JLT
+@SP
+A=M-1
+M=0
+@CE4
+0;JMP
+(CT4)
+@SP
+A=M-1
+M=-1
+(CE4)
+@SP
+AM=M-1
+D=M
+@calls.2
+M=D
+@9
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@3
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT5
+D;JGT
+@SP
+A=M-1
+M=0
+@CE5
+0;JMP
+(CT5)
+@SP
+A=M-1
+M=-1
+(CE5)
+@SP
+AM=M-1
+D=M
+@calls.3
+M=D
+@4
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@4
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT6
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE6
+0;JMP
+(CT6)
+@SP
+A=M-1
+M=-1
+(CE6)
+@SP
+AM=M-1
+D=M
+@calls.4
+M=D
+@4
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@5
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT7
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE7
+0;JMP
+(CT7)
+@SP
+A=M-1
+M=-1
+(CE7)
+@SP
+AM=M-1
+D=M
+@calls.5
+M=D
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(Main.fib)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT8
+D;JLT
+@SP
+A=M-1
+M=0
+@CE8
+0;JMP
+(CT8)
+@SP
+A=M-1
+M=-1
+(CE8)
+@SP
+AM=M-1
+D=M
+@Main.fib$BASE
+D;JNE
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@RET9
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Main.fib
+0;JMP
+(RET9)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@RET10
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Main.fib
+0;JMP
+(RET10)
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(Main.fib$BASE)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(Main.mul)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Main.mul$LOOP)
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT11
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE11
+0;JMP
+(CT11)
+@SP
+A=M-1
+M=-1
+(CE11)
+@SP
+AM=M-1
+D=M
+@Main.mul$DONE
+D;JNE
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@Main.mul$LOOP
+0;JMP
+(Main.mul$DONE)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(HALT)
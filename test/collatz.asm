@@ -0,0 +1,63 @@
+// Collatz sequence of RAM[100]: the values go to RAM[1000] on, the steps
+// to 1 to RAM[101]. Halving is a loop of subtractions, so machines run
+// for very different times and part ways at every branch; see lockstep.c.
+@1000
+D=A
+@ptr
+M=D
+@101
+M=0
+(LOOP)
+@100
+D=M
+@ptr
+A=M
+M=D
+@ptr
+M=M+1
+@100
+D=M
+D=D-1
+@END
+D;JLE
+@101
+M=M+1
+@100
+D=M
+@1
+D=D&A
+@ODD
+D;JNE
+@102
+M=0
+(HALF)
+@100
+D=M
+@2
+D=D-A
+@HALVED
+D;JLT
+@100
+M=D
+@102
+M=M+1
+@HALF
+0;JMP
+(HALVED)
+@102
+D=M
+@100
+M=D
+@LOOP
+0;JMP
+(ODD)
+@100
+D=M
+D=D+M
+D=D+M
+D=D+1
+@100
+M=D
+@LOOP
+0;JMP
+(END)
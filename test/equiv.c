@@ -0,0 +1,128 @@
+/*
+ * equiv.c
+ *
+ * Regression check for fused ops and OS emulation: a ROM run with them
+ * must end as the same ROM stepped instr by instr (-n) does, with the
+ * same registers, RAM and instrs executed. The fused machine runs again
+ * on small budgets, no hvm_run() may go over its own.
+ *
+ * With -e the words above the final SP are left out, emulated routines
+ * do not reproduce their locals and working stack, and so are the instr
+ * counts, an emulated routine counts as one.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "hvm.h"
+
+#define errprint(format, ...) fprintf (stderr, format, __VA_ARGS__);
+
+/* Stack of the VM translator's memory layout, from 256 up */
+#define STACK_END 2048
+
+/* Budgets of the second fused run */
+#define BUDGET 3
+
+static hvm_machine *load(unsigned flags, const char *symbols, const char *rom) {
+    hvm_machine *m = hvm_create(flags);
+    int err;
+
+    if (!m) {
+        errprint("error: [%s] %s\n", rom, hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+    if (symbols && (err = hvm_load_symbols(m, symbols))) {
+        errprint("error: [%s] %s\n", symbols, hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    if ((err = hvm_load_file(m, rom))) {
+        errprint("error: [%s] %s\n", rom, hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    return m;
+}
+
+/* Differences between the final states of ref and m, printed */
+static int compare(const char *what, hvm_machine *ref, long ref_steps, hvm_machine *m, long steps, int emulated) {
+    static const char *regs[] = {"A", "D", "PC"};
+    int sp = hvm_read(ref, 0);
+    int diff = 0;
+
+    if (!hvm_halted(ref) || !hvm_halted(m)) {
+        errprint("%s: did not halt\n", what)
+        return 1;
+    }
+    if (!emulated && steps != ref_steps) {
+        errprint("%s: %ld instrs, %ld stepped\n", what, steps, ref_steps)
+        ++diff;
+    }
+    for (int r = HVM_REG_A; r <= HVM_REG_PC; ++r) {
+        if (hvm_get_reg(m, r) != hvm_get_reg(ref, r)) {
+            errprint("%s: %s %d, %d stepped\n", what, regs[r], hvm_get_reg(m, r), hvm_get_reg(ref, r))
+            ++diff;
+        }
+    }
+    for (int a = 0; a < HVM_RAM_SIZE; ++a) {
+        if (emulated && a >= sp && a < STACK_END)
+            continue;
+        if (hvm_read(m, a) != hvm_read(ref, a) && diff++ < 16)
+            errprint("%s: RAM[%d] %d, %d stepped\n", what, a, hvm_read(m, a), hvm_read(ref, a))
+    }
+    return diff;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    unsigned flags = 0;
+    long max_steps = 100000000;
+    const char *symbols = NULL;
+    hvm_machine *ref, *m;
+    long ref_steps, steps, n;
+    int diff;
+
+    while ((opt = getopt(argc, argv, "exs:m:")) != -1) {
+        switch (opt) {
+            case 'e':
+                flags |= HVM_EMULATE_OS;
+                break;
+            case 'x':
+                flags |= HVM_EXTENDED;
+                break;
+            case 's':
+                symbols = optarg;
+                break;
+            case 'm':
+                max_steps = strtol(optarg, NULL, 0);
+                break;
+            default: /* '?' */
+                errprint("Usage: %s [-e] [-x] [-s file.map] [-m max_steps] rom.hex\n", argv[0])
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 1) {
+        errprint("Usage: %s [-e] [-x] [-s file.map] [-m max_steps] rom.hex\n", argv[0])
+        exit(EXIT_FAILURE);
+    }
+
+    ref = load(HVM_NO_FUSE | (flags & HVM_EXTENDED), NULL, argv[optind]);
+    ref_steps = hvm_run(ref, max_steps);
+
+    m = load(flags, symbols, argv[optind]);
+    steps = hvm_run(m, max_steps);
+    diff = compare("run", ref, ref_steps, m, steps, flags & HVM_EMULATE_OS);
+
+    hvm_reset(m);
+    for (steps = 0; !hvm_halted(m) && steps < max_steps; steps += n) {
+        if ((n = hvm_run(m, BUDGET)) > BUDGET) {
+            errprint("budget: %ld instrs run on a budget of %d at %ld\n", n, BUDGET, steps)
+            ++diff;
+            break;
+        }
+    }
+    diff += compare("budget", ref, ref_steps, m, steps, flags & HVM_EMULATE_OS);
+
+    hvm_destroy(ref);
+    hvm_destroy(m);
+    return diff ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,8 @@
+// Waits for a key, stores it in RAM[100] and halts; see sched.c.
+(WAIT)
+@KBD
+D=M
+@WAIT
+D;JEQ
+@100
+M=D
@@ -0,0 +1,115 @@
+/*
+ * lockstep.c
+ *
+ * Regression check for hvm_run_lockstep(): machines on one program, with
+ * different words at an input address, run in lockstep groups and each
+ * one alone. Every machine must end with the same registers, RAM, halted
+ * state and instr count both ways, once to the end and once cut short by
+ * a budget. Inputs are picked so the lanes part ways at the conditional
+ * jumps and more machines than HVM_LANES make a full and a partial group.
+ *
+ * Usage: hvm-lockstep-test [-x] [-a input_addr] rom.hex
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "hvm.h"
+
+#define errprint(format, ...) fprintf (stderr, format, __VA_ARGS__);
+
+#define MACHINES (HVM_LANES + 5)
+#define MAX_STEPS 100000000
+#define BUDGET 5000
+
+/* Odd and even, short and long sequences, repeats so some lanes stay together */
+static const int16_t inputs[MACHINES] = {27, 1, 2, 7, 27, 97, 6, 3, 16, 31, 41, 8, 27, 12, 55, 9, 1, 73, 18, 25, 5};
+
+/* Differences between machine i run alone (ref) and in lockstep (m), printed */
+static int compare(const char *what, int i, hvm_machine *ref, long ref_steps, hvm_machine *m, long steps) {
+    static const char *regs[] = {"A", "D", "PC"};
+    int diff = 0;
+
+    if (hvm_halted(m) != hvm_halted(ref) || steps != ref_steps) {
+        errprint("%s %d: halted %d after %ld instrs, alone %d after %ld\n", what, i, hvm_halted(m), steps,
+                 hvm_halted(ref), ref_steps)
+        ++diff;
+    }
+    for (int r = HVM_REG_A; r <= HVM_REG_PC; ++r) {
+        if (hvm_get_reg(m, r) != hvm_get_reg(ref, r)) {
+            errprint("%s %d: %s %d, %d alone\n", what, i, regs[r], hvm_get_reg(m, r), hvm_get_reg(ref, r))
+            ++diff;
+        }
+    }
+    for (int a = 0; a < HVM_RAM_SIZE; ++a) {
+        if (hvm_read(m, a) != hvm_read(ref, a) && diff++ < 16)
+            errprint("%s %d: RAM[%d] %d, %d alone\n", what, i, a, hvm_read(m, a), hvm_read(ref, a))
+    }
+    return diff;
+}
+
+/* Run every machine alone and all in lockstep on max_steps, compare */
+static int check(const char *what, hvm_program *prog, unsigned flags, uint16_t input, long max_steps) {
+    hvm_machine *ref[MACHINES], *ms[MACHINES];
+    long ref_steps[MACHINES], steps[MACHINES];
+    int diff = 0;
+
+    for (int i = 0; i < MACHINES; ++i) {
+        if (!(ref[i] = hvm_create(flags)) || !(ms[i] = hvm_create(flags))) {
+            errprint("error: %s\n", hvm_strerror(HVM_ERR_NOMEM))
+            exit(EXIT_FAILURE);
+        }
+        hvm_attach(ref[i], prog);
+        hvm_attach(ms[i], prog);
+        hvm_write(ref[i], input, inputs[i]);
+        hvm_write(ms[i], input, inputs[i]);
+        ref_steps[i] = hvm_run(ref[i], max_steps);
+    }
+    hvm_run_lockstep(ms, MACHINES, max_steps, steps);
+    for (int i = 0; i < MACHINES; ++i) {
+        diff += compare(what, i, ref[i], ref_steps[i], ms[i], steps[i]);
+        hvm_destroy(ref[i]);
+        hvm_destroy(ms[i]);
+    }
+    return diff;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    unsigned flags = 0;
+    uint16_t input = 100;
+    hvm_program *prog;
+    int err, diff;
+
+    while ((opt = getopt(argc, argv, "xa:")) != -1) {
+        switch (opt) {
+            case 'x':
+                flags |= HVM_EXTENDED;
+                break;
+            case 'a':
+                input = (uint16_t) strtol(optarg, NULL, 0);
+                break;
+            default: /* '?' */
+                errprint("Usage: %s [-x] [-a input_addr] rom.hex\n", argv[0])
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 1) {
+        errprint("Usage: %s [-x] [-a input_addr] rom.hex\n", argv[0])
+        exit(EXIT_FAILURE);
+    }
+    if (!(prog = hvm_program_create(flags))) {
+        errprint("error: [%s] %s\n", argv[optind], hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+    if ((err = hvm_program_load_file(prog, argv[optind]))) {
+        errprint("error: [%s] %s\n", argv[optind], hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+
+    diff = check("run", prog, flags, input, MAX_STEPS);
+    diff += check("budget", prog, flags, input, BUDGET);
+
+    hvm_program_release(prog);
+    return diff ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,1815 @@
+// Translated from the VM code below, see equiv.c. Pushes use the
+// @SP A=M M=D @SP M=M+1 form, return keeps FRAME and RET in R14 and R15.
+//
+// Math.multiply, Math.divide and Math.sqrt run emulated with -e, sqrt
+// of a negative falls back to the VM code. After the last emulated call
+// Sys.init copies R14 and R15 to statics, its own return overwrites
+// them, then sets R13, which pops in the emulated routines left behind.
+//
+// function Sys.init 0
+// push constant 123
+// push constant 45
+// neg
+// call Math.multiply 2
+// pop static 0
+// push constant 200
+// push constant 300
+// call Math.multiply 2
+// pop static 1
+// push constant 1000
+// push constant 7
+// call Math.divide 2
+// pop static 2
+// push constant 1000
+// neg
+// push constant 7
+// call Math.divide 2
+// pop static 3
+// push constant 1000
+// call Math.sqrt 1
+// pop static 4
+// push constant 5
+// neg
+// call Math.sqrt 1
+// pop static 5
+// push constant 6
+// push constant 7
+// call Math.multiply 2
+// pop static 6
+// push constant 13
+// pop pointer 0
+// push this 1
+// pop static 7
+// push this 2
+// pop static 8
+// push constant 3000
+// pop pointer 1
+// push constant 7
+// pop that 0
+// push constant 0
+// return
+// function Math.multiply 3
+// push constant 0
+// pop local 0
+// push argument 0
+// pop local 1
+// push constant 1
+// pop local 2
+// label LOOP
+// push local 2
+// push constant 0
+// eq
+// if-goto END
+// push argument 1
+// push local 2
+// and
+// push constant 0
+// eq
+// if-goto SKIP
+// push local 0
+// push local 1
+// add
+// pop local 0
+// label SKIP
+// push local 1
+// push local 1
+// add
+// pop local 1
+// push local 2
+// push local 2
+// add
+// pop local 2
+// goto LOOP
+// label END
+// push local 0
+// return
+// function Math.divide 2
+// push constant 0
+// pop local 0
+// push argument 0
+// push constant 0
+// lt
+// not
+// if-goto XPOS
+// push argument 0
+// neg
+// pop argument 0
+// push local 0
+// not
+// pop local 0
+// label XPOS
+// push argument 1
+// push constant 0
+// lt
+// not
+// if-goto YPOS
+// push argument 1
+// neg
+// pop argument 1
+// push local 0
+// not
+// pop local 0
+// label YPOS
+// label LOOP
+// push argument 0
+// push argument 1
+// lt
+// if-goto END
+// push argument 0
+// push argument 1
+// sub
+// pop argument 0
+// push local 1
+// push constant 1
+// add
+// pop local 1
+// goto LOOP
+// label END
+// push local 0
+// not
+// if-goto POS
+// push local 1
+// neg
+// pop local 1
+// label POS
+// push local 1
+// return
+// function Math.sqrt 1
+// label LOOP
+// push local 0
+// push constant 1
+// add
+// push local 0
+// push constant 1
+// add
+// call Math.multiply 2
+// push argument 0
+// gt
+// if-goto END
+// push local 0
+// push constant 1
+// add
+// pop local 0
+// goto LOOP
+// label END
+// push local 0
+// return
+
+@256
+D=A
+@SP
+M=D
+@RET1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@0
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Sys.init
+0;JMP
+(RET1)
+@HALT
+0;JMP
+(Sys.init)
+@123
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@45
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@RET2
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.multiply
+0;JMP
+(RET2)
+@SP
+AM=M-1
+D=M
+@Main.0
+M=D
+@200
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@300
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET3
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.multiply
+0;JMP
+(RET3)
+@SP
+AM=M-1
+D=M
+@Main.1
+M=D
+@1000
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET4
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.divide
+0;JMP
+(RET4)
+@SP
+AM=M-1
+D=M
+@Main.2
+M=D
+@1000
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET5
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.divide
+0;JMP
+(RET5)
+@SP
+AM=M-1
+D=M
+@Main.3
+M=D
+@1000
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET6
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.sqrt
+0;JMP
+(RET6)
+@SP
+AM=M-1
+D=M
+@Main.4
+M=D
+@5
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@RET7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.sqrt
+0;JMP
+(RET7)
+@SP
+AM=M-1
+D=M
+@Main.5
+M=D
+@6
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET8
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.multiply
+0;JMP
+(RET8)
+@SP
+AM=M-1
+D=M
+@Main.6
+M=D
+@13
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@3
+M=D
+@1
+D=A
+@THIS
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@Main.7
+M=D
+@2
+D=A
+@THIS
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@Main.8
+M=D
+@3000
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@4
+M=D
+@7
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@THAT
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R14
+M=D
+@5
+A=D-A
+D=M
+@R15
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R14
+AM=M-1
+D=M
+@THAT
+M=D
+@R14
+AM=M-1
+D=M
+@THIS
+M=D
+@R14
+AM=M-1
+D=M
+@ARG
+M=D
+@R14
+AM=M-1
+D=M
+@LCL
+M=D
+@R15
+A=M
+0;JMP
+(Math.multiply)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Math.multiply$LOOP)
+@2
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT9
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE9
+0;JMP
+(CT9)
+@SP
+A=M-1
+M=-1
+(CE9)
+@SP
+AM=M-1
+D=M
+@Math.multiply$END
+D;JNE
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D&M
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT10
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE10
+0;JMP
+(CT10)
+@SP
+A=M-1
+M=-1
+(CE10)
+@SP
+AM=M-1
+D=M
+@Math.multiply$SKIP
+D;JNE
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Math.multiply$SKIP)
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@2
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@2
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@Math.multiply$LOOP
+0;JMP
+(Math.multiply$END)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R14
+M=D
+@5
+A=D-A
+D=M
+@R15
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R14
+AM=M-1
+D=M
+@THAT
+M=D
+@R14
+AM=M-1
+D=M
+@THIS
+M=D
+@R14
+AM=M-1
+D=M
+@ARG
+M=D
+@R14
+AM=M-1
+D=M
+@LCL
+M=D
+@R15
+A=M
+0;JMP
+(Math.divide)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT11
+D;JLT
+@SP
+A=M-1
+M=0
+@CE11
+0;JMP
+(CT11)
+@SP
+A=M-1
+M=-1
+(CE11)
+@SP
+A=M-1
+M=!M
+@SP
+AM=M-1
+D=M
+@Math.divide$XPOS
+D;JNE
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@0
+D=A
+@ARG
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=!M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Math.divide$XPOS)
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT12
+D;JLT
+@SP
+A=M-1
+M=0
+@CE12
+0;JMP
+(CT12)
+@SP
+A=M-1
+M=-1
+(CE12)
+@SP
+A=M-1
+M=!M
+@SP
+AM=M-1
+D=M
+@Math.divide$YPOS
+D;JNE
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@1
+D=A
+@ARG
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=!M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Math.divide$YPOS)
+(Math.divide$LOOP)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT13
+D;JLT
+@SP
+A=M-1
+M=0
+@CE13
+0;JMP
+(CT13)
+@SP
+A=M-1
+M=-1
+(CE13)
+@SP
+AM=M-1
+D=M
+@Math.divide$END
+D;JNE
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@0
+D=A
+@ARG
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@Math.divide$LOOP
+0;JMP
+(Math.divide$END)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=!M
+@SP
+AM=M-1
+D=M
+@Math.divide$POS
+D;JNE
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+A=M-1
+M=-M
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+(Math.divide$POS)
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R14
+M=D
+@5
+A=D-A
+D=M
+@R15
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R14
+AM=M-1
+D=M
+@THAT
+M=D
+@R14
+AM=M-1
+D=M
+@THIS
+M=D
+@R14
+AM=M-1
+D=M
+@ARG
+M=D
+@R14
+AM=M-1
+D=M
+@LCL
+M=D
+@R15
+A=M
+0;JMP
+(Math.sqrt)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+(Math.sqrt$LOOP)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@RET14
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Math.multiply
+0;JMP
+(RET14)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT15
+D;JGT
+@SP
+A=M-1
+M=0
+@CE15
+0;JMP
+(CT15)
+@SP
+A=M-1
+M=-1
+(CE15)
+@SP
+AM=M-1
+D=M
+@Math.sqrt$END
+D;JNE
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@Math.sqrt$LOOP
+0;JMP
+(Math.sqrt$END)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R14
+M=D
+@5
+A=D-A
+D=M
+@R15
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R14
+AM=M-1
+D=M
+@THAT
+M=D
+@R14
+AM=M-1
+D=M
+@THIS
+M=D
+@R14
+AM=M-1
+D=M
+@ARG
+M=D
+@R14
+AM=M-1
+D=M
+@LCL
+M=D
+@R15
+A=M
+0;JMP
+(HALT)
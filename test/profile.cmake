@@ -0,0 +1,18 @@
+# cmake -DHVM=hvm -DROM=rom.hex -DOUT=dir -P profile.cmake
+# The --profile report of a fused run must equal that of the run stepped with -n.
+foreach (mode fused stepped)
+    if (mode STREQUAL "stepped")
+        set(opts -n)
+    else ()
+        set(opts)
+    endif ()
+    execute_process(COMMAND ${HVM} ${opts} --profile ${OUT}/${mode}.txt ${ROM}
+                    OUTPUT_QUIET RESULT_VARIABLE status)
+    if (status)
+        message(FATAL_ERROR "${HVM} ${opts} ${ROM}: ${status}")
+    endif ()
+    file(READ ${OUT}/${mode}.txt ${mode})
+endforeach ()
+if (NOT fused STREQUAL stepped)
+    message(FATAL_ERROR "${ROM}: --profile differs from -n, see ${OUT}")
+endif ()
@@ -0,0 +1,90 @@
+/*
+ * sched.c
+ *
+ * Keyboard waits under hvm_sched: a machine that only polls for a key is
+ * parked, one that polls once a frame while it keeps counting is not, and
+ * a key wakes the first and ends both.
+ *
+ * Usage: hvm-sched-test [-n] kbd.hex anim.hex
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "hvm.h"
+
+#define errprint(format, ...) fprintf (stderr, format, __VA_ARGS__);
+
+#define QUANTUM 1000
+#define STEPS 200000
+#define KEY 'k'
+
+static hvm_machine *load(unsigned flags, const char *rom) {
+    hvm_machine *m = hvm_create(flags);
+    int err;
+
+    if (!m) {
+        errprint("error: [%s] %s\n", rom, hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+    if ((err = hvm_load_file(m, rom))) {
+        errprint("error: [%s] %s\n", rom, hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    return m;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned flags = 0;
+    hvm_sched *s;
+    hvm_machine *kbd, *anim;
+    int k, a, fail = 0;
+
+    if (argc > 1 && argv[1][0] == '-' && argv[1][1] == 'n') {
+        flags |= HVM_NO_FUSE;
+        ++argv;
+        --argc;
+    }
+    if (argc != 3) {
+        errprint("Usage: %s [-n] kbd.hex anim.hex\n", argv[0])
+        exit(EXIT_FAILURE);
+    }
+    kbd = load(flags, argv[1]);
+    anim = load(flags, argv[2]);
+    if (!(s = hvm_sched_create(QUANTUM)) || (k = hvm_sched_add(s, kbd, 1)) < 0 || (a = hvm_sched_add(s, anim, 1)) < 0) {
+        errprint("error: %s\n", hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+
+    hvm_sched_run(s, STEPS);
+    if (hvm_sched_state(s, k) != HVM_SCHED_KBD_WAIT) {
+        errprint("blocked: state %d, not parked\n", hvm_sched_state(s, k))
+        ++fail;
+    }
+    if (hvm_sched_state(s, a) != HVM_SCHED_RUNNABLE) {
+        errprint("animation: state %d, parked\n", hvm_sched_state(s, a))
+        ++fail;
+    }
+    // parked early, the animation got nearly all the turns
+    if (hvm_read(anim, 100) < STEPS / 2 / 6) {
+        errprint("animation: %d frames in %d instrs\n", hvm_read(anim, 100), STEPS)
+        ++fail;
+    }
+
+    hvm_sched_key(s, k, KEY);
+    hvm_sched_key(s, a, KEY);
+    hvm_sched_run(s, STEPS);
+    if (hvm_sched_runnable(s) || !hvm_halted(kbd) || !hvm_halted(anim)) {
+        errprint("key: %d machines still runnable\n", hvm_sched_runnable(s))
+        ++fail;
+    }
+    if (hvm_read(kbd, 100) != KEY || hvm_read(anim, 101) != KEY) {
+        errprint("key: read %d and %d\n", hvm_read(kbd, 100), hvm_read(anim, 101))
+        ++fail;
+    }
+
+    hvm_sched_destroy(s);
+    hvm_destroy(kbd);
+    hvm_destroy(anim);
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
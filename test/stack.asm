@@ -0,0 +1,1024 @@
+// Translated from the VM code below, see equiv.c. Pushes use the
+// @SP A=M M=D @SP M=M+1 form, segment addresses @i D=A @seg first.
+//
+// function Sys.init 3
+// push constant 3000
+// pop pointer 0
+// push constant 3100
+// pop pointer 1
+// push constant 11
+// pop this 2
+// push constant 22
+// pop that 3
+// push this 2
+// push that 3
+// add
+// pop local 0
+// push constant 5
+// push constant 9
+// sub
+// pop local 1
+// push constant 12
+// push constant 10
+// and
+// push constant 1
+// or
+// not
+// neg
+// pop local 2
+// push local 0
+// push local 1
+// eq
+// push local 0
+// push local 0
+// eq
+// push local 1
+// push local 0
+// gt
+// push local 0
+// push local 1
+// gt
+// push local 1
+// push local 0
+// lt
+// push local 0
+// push local 1
+// lt
+// pop temp 0
+// pop temp 1
+// pop temp 2
+// pop temp 3
+// pop temp 4
+// pop temp 5
+// push temp 0
+// pop static 3
+// push pointer 1
+// pop static 4
+// push constant 100
+// call Sys.count 1
+// pop static 5
+// push local 2
+// push constant 4
+// call Sys.sum 2
+// pop static 6
+// push constant 0
+// return
+// function Sys.count 1
+// label L
+// push argument 0
+// if-goto NZ
+// goto END
+// label NZ
+// push argument 0
+// push constant 1
+// sub
+// pop argument 0
+// push local 0
+// push constant 1
+// add
+// pop local 0
+// goto L
+// label END
+// push local 0
+// return
+// function Sys.sum 0
+// push argument 0
+// push argument 1
+// add
+// return
+
+@256
+D=A
+@SP
+M=D
+@RET1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@0
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Sys.init
+0;JMP
+(RET1)
+@HALT
+0;JMP
+(Sys.init)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@3000
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@3
+M=D
+@3100
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@4
+M=D
+@11
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@2
+D=A
+@THIS
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@22
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@3
+D=A
+@THAT
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@2
+D=A
+@THIS
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@3
+D=A
+@THAT
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@5
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@9
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@1
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@12
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@10
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D&M
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D|M
+@SP
+A=M-1
+M=!M
+@SP
+A=M-1
+M=-M
+@2
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT2
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE2
+0;JMP
+(CT2)
+@SP
+A=M-1
+M=-1
+(CE2)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT3
+D;JEQ
+@SP
+A=M-1
+M=0
+@CE3
+0;JMP
+(CT3)
+@SP
+A=M-1
+M=-1
+(CE3)
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT4
+D;JGT
+@SP
+A=M-1
+M=0
+@CE4
+0;JMP
+(CT4)
+@SP
+A=M-1
+M=-1
+(CE4)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT5
+D;JGT
+@SP
+A=M-1
+M=0
+@CE5
+0;JMP
+(CT5)
+@SP
+A=M-1
+M=-1
+(CE5)
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT6
+D;JLT
+@SP
+A=M-1
+M=0
+@CE6
+0;JMP
+(CT6)
+@SP
+A=M-1
+M=-1
+(CE6)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+D=M-D
+@CT7
+D;JLT
+@SP
+A=M-1
+M=0
+@CE7
+0;JMP
+(CT7)
+@SP
+A=M-1
+M=-1
+(CE7)
+@SP
+AM=M-1
+D=M
+@5
+M=D
+@SP
+AM=M-1
+D=M
+@6
+M=D
+@SP
+AM=M-1
+D=M
+@7
+M=D
+@SP
+AM=M-1
+D=M
+@8
+M=D
+@SP
+AM=M-1
+D=M
+@9
+M=D
+@SP
+AM=M-1
+D=M
+@10
+M=D
+@5
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@stack.3
+M=D
+@4
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@stack.4
+M=D
+@100
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET8
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@1
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Sys.count
+0;JMP
+(RET8)
+@SP
+AM=M-1
+D=M
+@stack.5
+M=D
+@2
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@4
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@RET9
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@ARG
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THIS
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@THAT
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+D=M
+@5
+D=D-A
+@2
+D=D-A
+@ARG
+M=D
+@SP
+D=M
+@LCL
+M=D
+@Sys.sum
+0;JMP
+(RET9)
+@SP
+AM=M-1
+D=M
+@stack.6
+M=D
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(Sys.count)
+@0
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+(Sys.count$L)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+@Sys.count$NZ
+D;JNE
+@Sys.count$END
+0;JMP
+(Sys.count$NZ)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=M-D
+@0
+D=A
+@ARG
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@0
+D=A
+@LCL
+D=D+M
+@R13
+M=D
+@SP
+AM=M-1
+D=M
+@R13
+A=M
+M=D
+@Sys.count$L
+0;JMP
+(Sys.count$END)
+@0
+D=A
+@LCL
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(Sys.sum)
+@0
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@1
+D=A
+@ARG
+A=D+M
+D=M
+@SP
+A=M
+M=D
+@SP
+M=M+1
+@SP
+AM=M-1
+D=M
+A=A-1
+M=D+M
+@LCL
+D=M
+@R13
+M=D
+@5
+A=D-A
+D=M
+@R14
+M=D
+@SP
+AM=M-1
+D=M
+@ARG
+A=M
+M=D
+@ARG
+D=M+1
+@SP
+M=D
+@R13
+AM=M-1
+D=M
+@THAT
+M=D
+@R13
+AM=M-1
+D=M
+@THIS
+M=D
+@R13
+AM=M-1
+D=M
+@ARG
+M=D
+@R13
+AM=M-1
+D=M
+@LCL
+M=D
+@R14
+A=M
+0;JMP
+(HALT)
@@ -0,0 +1,175 @@
+/*
+ * tracedump.c
+ *
+ * hvm-trace, decoder for the rings hvm --trace writes. The trace holds
+ * only where control landed and how far it ran straight from there, the
+ * instrs are read back from the ROM. The jump ending such a run was taken,
+ * those before it fell through. Fused compare sequences are recorded as
+ * the runs their instrs would make, so a trace reads the same with -n.
+ * Oldest first.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "disasm.h"
+#include "hvm.h"
+
+#define errprint(format, ...) fprintf (stderr, format, __VA_ARGS__);
+
+typedef struct {
+    uint16_t entry;
+    uint16_t len;
+} TraceBlock;
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | (uint32_t) p[1] << 8u | (uint32_t) p[2] << 16u | (uint32_t) p[3] << 24u;
+}
+
+/* Varint at *at, below end, -1 if cut short */
+static long get_varint(const uint8_t *chunk, unsigned *at, unsigned end) {
+    unsigned long v = 0;
+
+    for (unsigned shift = 0; *at < end && shift < 21; shift += 7) {
+        uint8_t b = chunk[(*at)++];
+        v |= (unsigned long) (b & 0x7fu) << shift;
+        if (!(b & 0x80u))
+            return (long) v;
+    }
+    return -1;
+}
+
+/* Runs of every chunk, oldest first, into *out. Returns the count, -1 if the file is no trace. */
+static long trace_read(FILE *fp, TraceBlock **out) {
+    uint8_t head[16];
+    uint32_t size, chunks, last;
+    uint8_t *ring;
+    TraceBlock *blocks;
+    long n = 0;
+
+    if (fread(head, 1, sizeof(head), fp) != sizeof(head) || memcmp(head, "HVMT", 4))
+        return -1;
+    size = get32(head + 4);
+    chunks = get32(head + 8);
+    last = get32(head + 12);
+    if (size < 8 || size > 0x10000 || !chunks || last >= chunks)
+        return -1;
+    if (!(ring = malloc((size_t) size * chunks)) || !(blocks = malloc(sizeof(TraceBlock) * (size / 2) * chunks))) {
+        free(ring);
+        return -1;
+    }
+    if (fread(ring, size, chunks, fp) != chunks) {
+        free(ring);
+        free(blocks);
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < chunks; ++c) {
+        const uint8_t *chunk = ring + (size_t) ((last + 1 + c) % chunks) * size;
+        unsigned used = chunk[0] | chunk[1] << 8u, at = 2;
+        uint16_t prev = 0;
+
+        if (used > size)
+            used = size;
+        while (at < used) {
+            long delta = get_varint(chunk, &at, used);
+            long len = get_varint(chunk, &at, used);
+
+            if (delta < 0 || len < 0)
+                break;
+            // zigzag
+            blocks[n].entry = (uint16_t) (prev + (uint16_t) ((delta >> 1) ^ -(delta & 1)));
+            blocks[n].len = (uint16_t) len;
+            prev = (uint16_t) (blocks[n].entry + len);
+            ++n;
+        }
+    }
+    free(ring);
+    *out = blocks;
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    int err;
+    int extended = 0;
+    const char *symbols = NULL;
+    TraceBlock *blocks;
+    long n;
+    FILE *fp;
+    hvm_machine *m;
+    char text[32];
+
+    while ((opt = getopt(argc, argv, "xs:")) != -1) {
+        switch (opt) {
+            case 'x':
+                extended = 1;
+                break;
+            case 's':
+                symbols = optarg;
+                break;
+            default: /* '?' */
+                errprint("Usage: %s [-x] [-s file.map] trace rom.hex\n", argv[0])
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 2) {
+        errprint("Usage: %s [-x] [-s file.map] trace rom.hex\n", argv[0])
+        exit(EXIT_FAILURE);
+    }
+
+    if (!(m = hvm_create(extended ? HVM_EXTENDED : 0))) {
+        errprint("error: [%s] %s\n", argv[optind + 1], hvm_strerror(HVM_ERR_NOMEM))
+        exit(EXIT_FAILURE);
+    }
+    if (symbols && (err = hvm_load_symbols(m, symbols))) {
+        errprint("error: [%s] %s\n", symbols, hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    if ((err = hvm_load_file(m, argv[optind + 1]))) {
+        errprint("error: [%s] %s\n", argv[optind + 1], hvm_strerror(err))
+        exit(EXIT_FAILURE);
+    }
+    if (!(fp = fopen(argv[optind], "rb"))) {
+        errprint("error: [%s] %s\n", argv[optind], hvm_strerror(HVM_ERR_IO))
+        exit(EXIT_FAILURE);
+    }
+    n = trace_read(fp, &blocks);
+    fclose(fp);
+    if (n < 0) {
+        errprint("error: [%s] not a trace\n", argv[optind])
+        exit(EXIT_FAILURE);
+    }
+
+    for (long i = 0; i < n; ++i) {
+        uint16_t entry = blocks[i].entry, next = (uint16_t) (entry + blocks[i].len);
+        const char *name = hvm_label(m, entry);
+
+        if (name)
+            printf("%s:\n", name);
+        for (uint16_t pc = entry; pc != next; ++pc) {
+            uint16_t instr = hvm_rom(m, pc & (HVM_ROM_SIZE - 1));
+
+            disasm(instr, extended, text, sizeof(text));
+            if ((uint16_t) (pc + 1) != next) {
+                if (disasm_is_jump(instr, extended))
+                    printf("%5d  %-20s ; not taken\n", pc, text);
+                else
+                    printf("%5d  %s\n", pc, text);
+            } else if (i + 1 == n) {
+                printf("%5d  %-20s ; end\n", pc, text);
+            } else if (disasm_is_jump(instr, extended)) {
+                printf("%5d  %-20s ; taken -> %d\n", pc, text, blocks[i + 1].entry);
+            } else {
+                printf("%5d  %-20s ; -> %d\n", pc, text, blocks[i + 1].entry);
+            }
+        }
+    }
+    printf("%ld runs\n", n);
+
+    free(blocks);
+    hvm_destroy(m);
+    return 0;
+}